@@ -5,6 +5,7 @@
 #include <stdint.h>
 #include <math.h>
 #include <limits.h>
+#include <float.h>
 #include <stdio.h>
 #include <stdbool.h>
 #include "upng.h"
@@ -17,18 +18,22 @@
 
 // Game settings
 #define TILE_SIZE 64                // Size of each tile in pixels
+#define TILE_SHIFT 6                // log2(TILE_SIZE), tiles must be a power of two
 #define MINIMAP_SCALE_FACTOR 0.25f  // Scale factor for the minimap
 
-// Screen dimensions based on the map size
+// Screen dimensions based on the map size, overridable at build time
+#ifndef SCREEN_WIDTH
 #define SCREEN_WIDTH (MAP_NUM_COLS * TILE_SIZE)
+#endif
+#ifndef SCREEN_HEIGHT
 #define SCREEN_HEIGHT (MAP_NUM_ROWS * TILE_SIZE)
+#endif
 
 // Field of View settings
 #define FOV_ANGLE (60 * (PI / 180)) // Field of view angle in radians
 
 // Raycasting settings
 #define NUM_RAYS SCREEN_WIDTH            // Number of rays to cast
-#define PROJ_PLANE ((SCREEN_WIDTH / 2) / tan(FOV_ANGLE / 2)) // Projection plane distance
 
 // Frame settings
 #define FPS 30                       // Frames per second
@@ -37,35 +42,201 @@
 // Map dimensions
 #define MAP_NUM_ROWS 13 // Number of rows in the map
 #define MAP_NUM_COLS 20 // Number of columns in the map
+#define OCCUPANCY_ROW_WORDS ((MAP_NUM_COLS + 63) >> 6) // 64-bit words per occupancy row
 
 // Texture settings
-#define NUM_TEXTURES 8 // Number of textures used in the game
+#define NUM_TEXTURES 9   // Number of textures used in the game
+#define GRATE_TEXTURE 8  // See-through grate, drawn in code when its image is missing
+#define GRATE_SIZE 64    // Width and height of the drawn grate
+#define MAX_MIP_LEVELS 10 // Mip levels kept per texture (512 texels down to 1)
+#define ATLAS_ALIGN 16    // Texels per cache line, textures start on one
+
+// Material flags
+#define MATERIAL_SEE_THROUGH 0x01 // Rays continue past cells of this material
+#define MAX_RAY_HITS 4            // See-through hits kept per column
+#define GBUFFER_LAYERS (MAX_RAY_HITS + 1) // Opaque hit plus see-through hits
+
+// Shading settings
+#define FOG_LEVELS 32 // Quantized distances with their own fog table
+
+// Threading settings
+#define MAX_WORKERS 64      // Upper bound on worker threads in the pool
+#define MAX_PIPELINE_DEPTH 3 // Upper bound on frames in flight
+#define RAY_CHUNK_SIZE 32   // Columns handed to a worker at a time
+#define ADAPTIVE_CHUNK_SIZE 320 // Columns refined together in adaptive mode
+#define RENDER_BAND_SIZE 64 // Columns rasterized by a worker at a time
+#define PRESENT_ROW_CHUNK 16 // Framebuffer rows scaled by a worker at a time
+
+// Fixed point settings
+#define FIXED_SHIFT 16                   // Fraction bits of fixed_t (16.16)
+#define FIXED_ONE (1 << FIXED_SHIFT)     // 1.0 in fixed point
+#define FIXED_FRAC (FIXED_ONE - 1)       // Mask of the fraction bits
+#define ANGLE_STEPS 16384                // Binary angle steps per turn
+#define FIXED_MUL(a, b) ((fixed_t)(((int64_t)(a) * (b)) >> FIXED_SHIFT))
 
 // Color type definition
 typedef uint32_t color_t;
 
+// Fixed point number type definition
+typedef int32_t fixed_t;
+
+/* Runtime Configuration */
+
+// Ways a finished frame reaches the screen (MAZE_PRESENT)
+typedef enum {
+    PRESENT_RENDERER,  // Streaming texture stretched by the SDL_Renderer
+    PRESENT_SURFACE,   // SDL_BlitScaled onto the window surface
+    PRESENT_SCALED     // Integer nearest-neighbour scaling onto the window surface
+} present_mode_t;
+
+// Struct holding settings read from the environment at startup
+typedef struct {
+    int numThreads;        // Threads used per frame (MAZE_THREADS, 0 = one per CPU)
+    bool simdRays;         // Trace rays in SIMD packets when supported (MAZE_SIMD)
+    bool fixedPoint;       // Render the 3D view with the 16.16 engine (MAZE_FIXED)
+    int adaptiveStep;      // Column spacing of edge-finding casts (MAZE_ADAPTIVE, 0 = off)
+    size_t rayTableBytes;  // Memory budget of the baked ray table (MAZE_RAY_TABLE_MB, 0 = off)
+    int benchFrames;       // Frames to time before exiting (MAZE_BENCH, 0 = play normally)
+    int fogDistance;       // Tiles at which fog turns black (MAZE_FOG, 0 = off)
+    bool columnMajor;      // Store the framebuffer column by column (MAZE_COLUMN_MAJOR)
+    bool bufferedPresent;  // Draw into a malloc'd buffer and copy it at present (MAZE_BUFFERED)
+    int halfRateTiles;     // Distance where floor and ceiling drop to 1/2 rate (MAZE_HALF_RATE, 0 = off)
+    int quarterRateTiles;  // Distance where they drop to 1/4 rate (MAZE_QUARTER_RATE, 0 = off)
+    present_mode_t presentMode; // Present backend (MAZE_PRESENT)
+    int pipelineDepth;     // Frames in flight, 1 = no render thread (MAZE_PIPELINE)
+} config_t;
+
+extern config_t config; // Global runtime configuration
+
+// Reads the runtime configuration from environment variables
+void loadConfig(void);
+
+/* Benchmark */
+
+// Timed stages of a frame
+typedef enum {
+    BENCH_CAST,       // Ray casting
+    BENCH_RENDER,     // Rasterizing walls, floor, ceiling and minimap
+    BENCH_PRESENT,    // Handing the frame to SDL
+    BENCH_FRAME,      // Whole main loop iteration, the throughput
+    BENCH_NUM_STAGES
+} bench_stage_t;
+
+// Per-frame event counters
+typedef enum {
+    BENCH_RAY_HITS,     // Wall hits recorded, see-through ones included
+    BENCH_RAYS_CAST,    // Columns traced through the grid or the ray table
+    BENCH_PLANE_TEXELS, // Floor and ceiling texels sampled
+    BENCH_NUM_COUNTERS
+} bench_counter_t;
+
+// Starts timing a stage when benchmarking
+void benchStart(bench_stage_t stage);
+
+// Stops timing a stage when benchmarking
+void benchStop(bench_stage_t stage);
+
+// Adds to a counter when benchmarking
+void benchCount(bench_counter_t counter, int amount);
+
+// Marks the end of a frame, returns false once enough frames were timed
+bool benchFrameDone(void);
+
+// Prints the per-frame averages
+void benchReport(void);
+
+/* Worker Pool */
+
+// Job run on a sub-range [start, end) of a larger index range
+typedef void (*worker_job_t)(int start, int end, void *data);
+
+// Starts the persistent worker threads
+bool initWorkers(int numThreads);
+
+// Splits [0, total) into chunks and runs job on them across the pool
+void runWorkers(worker_job_t job, int total, int chunkSize, void *data);
+
+// Stops and joins the worker threads
+void destroyWorkers(void);
+
 /* Input Handling */
 
 // Function to process user input
 void handleInput(void);
-extern bool isGameRunning; // Flag indicating if the game is currently running
+extern bool GameRunning; // Flag indicating if the game is currently running
 
 /* Rendering Functions */
 
+// Framebuffer the renderer draws into, in either pixel order
+typedef struct {
+    color_t *pixels;       // SCREEN_WIDTH * SCREEN_HEIGHT pixels
+    int xStride;           // Pixels between horizontally adjacent pixels
+    int yStride;           // Pixels between vertically adjacent pixels
+} framebuffer_t;
+
+extern framebuffer_t framebuffer; // Framebuffer of the current frame
+
+// Returns the address of a framebuffer pixel
+static inline color_t *framebufferAt(int x, int y)
+{
+    return (&framebuffer.pixels[x * framebuffer.xStride + y * framebuffer.yStride]);
+}
+
+// 32-bit pixel format shared by the framebuffer, textures and colors
+typedef struct {
+    Uint32 format;         // SDL_PIXELFORMAT_* value, alpha in the top byte
+    uint8_t rShift;        // Bit position of red
+    uint8_t gShift;        // Bit position of green
+    uint8_t bShift;        // Bit position of blue
+    uint8_t aShift;        // Bit position of alpha
+} pixel_format_t;
+
+extern pixel_format_t pixelFormat; // Format chosen from the window at startup
+
+#define BACKGROUND_COLOR 0xFF000000 // Opaque black, in every supported format
+
+// Packs channels into a color of the framebuffer's pixel format
+static inline color_t packColor(uint8_t r, uint8_t g, uint8_t b, uint8_t a)
+{
+    return (((color_t)r << pixelFormat.rShift) | ((color_t)g << pixelFormat.gShift)
+            | ((color_t)b << pixelFormat.bShift) | ((color_t)a << pixelFormat.aShift));
+}
+
 // Initializes the game window
 bool initializeWindow(void);
 
 // Cleans up and destroys the game window
 void destroyWindow(void);
 
-// Clears the color buffer with a specified color
-void clearColorBuffer(color_t color);
+// Points the framebuffer at the pixels of a new frame
+void lockColorBuffer(int slot);
+
+// Fills a run of framebuffer pixels with one color
+void fillSpan(color_t *pixels, int count, int stride, color_t color);
 
-// Renders the game scene
-void renderGame(void);
+#ifdef DEBUG_OVERDRAW
+// Records framebuffer writes of the 3D view pass
+void countWrites(const color_t *pixels, int count, int stride);
 
-// Displays the contents of the color buffer on the screen
-void renderColorBuffer(void);
+// Checks that the 3D view pass wrote every pixel of the frame
+void checkOverdraw(void);
+
+// Prints the coverage totals of the checked frames
+void overdrawReport(void);
+#else
+#define countWrites(pixels, count, stride) ((void)0)
+#define checkOverdraw() ((void)0)
+#define overdrawReport() ((void)0)
+#endif
+
+// Casts and draws a frame from the camera pose
+void render_game(void);
+
+// Displays the contents of a color buffer on the screen
+void renderColorBuffer(int slot);
+
+// Describes the present backend in use
+const char *getPresentName(void);
 
 // Draws a single pixel at specified coordinates with a given color
 void drawPixel(int x, int y, color_t color);
@@ -79,7 +250,7 @@ void drawLine(int x0, int y0, int x1, int y1, color_t color);
 /* Map Functions */
 
 // Checks for collision with walls at specified coordinates
-bool detectCollision(float x, float y);
+bool DetectCollision(float x, float y);
 
 // Verifies if the given coordinates are within the bounds of the map
 bool isInsideMap(float x, float y);
@@ -90,6 +261,32 @@ void renderMap(void);
 // Retrieves the value of a specific cell in the map
 int getMapValue(int row, int col);
 
+// Returns the cell texture IDs as one row-major byte array
+const uint8_t *getMaterialPlane(void);
+
+// Returns the empty radius of the cells as one row-major byte array
+const uint8_t *getRadiusPlane(void);
+
+extern uint64_t occupancyPlane[MAP_NUM_ROWS][OCCUPANCY_ROW_WORDS]; // Wall bits
+
+// Checks the occupancy bit of a cell inside the map
+static inline bool isCellSolid(int row, int col)
+{
+    return ((occupancyPlane[row][col >> 6] >> (col & 63)) & 1);
+}
+
+// Checks whether rays continue past a cell content
+bool isSeeThrough(int content);
+
+// Checks whether the map has any see-through cells
+bool mapHasSeeThrough(void);
+
+// Rebuilds the acceleration data of the map, call after loading a map
+void prepareMap(void);
+
+// Returns the Chebyshev distance from a cell to the nearest wall
+int getEmptyRadius(int row, int col);
+
 /* Player Structure and Functions */
 
 // Struct representing the player character
@@ -103,9 +300,9 @@ typedef struct {
     float rotationAngle;   // Current rotation angle of the player
     float walkSpeed;       // Speed of walking
     float turnSpeed;       // Speed of turning
-} Player;
+} player_t;
 
-extern Player player; // Global instance of the player
+extern player_t player; // Global instance of the player
 
 // Moves the player based on input and time elapsed
 void movePlayer(float deltaTime);
@@ -117,15 +314,44 @@ void renderPlayer(void);
 
 // Struct representing a ray for raycasting
 typedef struct {
-    float rayAngle;        // Angle of the ray
+    float rayAngle;        // Angle of the ray (not set in fixed point mode)
     float wallHitX;       // X coordinate of the wall hit
     float wallHitY;       // Y coordinate of the wall hit
-    float distance;       // Distance from the player to the wall
+    float distance;       // Distance to the wall (not set in fixed point mode)
+    float perpDistance;   // Distance projected on the view direction
+    fixed_t perpDistanceFx; // Perpendicular distance in tiles (fixed point mode)
     bool wasHitVertical;  // Indicates if the ray hit a vertical wall
     int wallHitContent;   // Identifier for the wall hit content
-} Ray;
+    int textureOffsetX;   // Texture column at the wall hit
+    int mapX;             // Column of the hit cell
+    int mapY;             // Row of the hit cell
+    int numHits;          // See-through hits in front of this one
+} ray_t;
 
-extern Ray rays[NUM_RAYS]; // Array of rays used for rendering
+extern ray_t rays[NUM_RAYS]; // Array of rays used for rendering
+extern ray_t rayHits[NUM_RAYS][MAX_RAY_HITS]; // See-through hits, front to back
+
+// Struct holding the DDA state of a ray while it walks the grid
+typedef struct {
+    float rayAngle;       // Normalized angle of the ray
+    float dirX;           // X component of the ray direction
+    float dirY;           // Y component of the ray direction
+    float deltaDistX;     // Ray length between two vertical grid lines
+    float deltaDistY;     // Ray length between two horizontal grid lines
+    float sideDistX;      // Ray length to the next vertical grid line
+    float sideDistY;      // Ray length to the next horizontal grid line
+    float firstSideDistX; // Ray length to the first vertical grid line
+    float firstSideDistY; // Ray length to the first horizontal grid line
+    int startX;           // Column of the cell the ray starts in
+    int startY;           // Row of the cell the ray starts in
+    int mapX;             // Current cell column
+    int mapY;             // Current cell row
+    int stepX;            // Column step (-1 or 1)
+    int stepY;            // Row step (-1 or 1)
+    float distance;       // Ray length to the last crossed grid line
+    bool vertical;        // Whether the last crossed grid line was vertical
+    int content;          // Content of the current cell
+} rayWalk_t;
 
 // Calculates the distance between two points
 float distanceBetweenPoints(float x1, float y1, float x2, float y2);
@@ -148,14 +374,166 @@ void castAllRays(void);
 // Casts a single ray at a specified angle and strip ID
 void castRay(float rayAngle, int stripId);
 
+// Returns the ray angle for a screen column
+float getColumnAngle(int col);
+
+// Prepares the DDA state of a ray leaving the player
+void initRayWalk(rayWalk_t *walk, float rayAngle);
+
+// Prepares the DDA state of a ray leaving any point of the map
+void initRayWalkAt(rayWalk_t *walk, float originX, float originY, float rayAngle);
+
+// Moves a walk to a cell with the side distances walkRay has there
+void seekRayWalk(rayWalk_t *walk, int mapX, int mapY);
+
+// Walks the grid until the ray enters a wall or leaves the map
+void walkRay(rayWalk_t *walk);
+
+// Fills the ray of a column from a walk, carrying it through see-through cells
+void storeRayHit(int col, rayWalk_t *walk);
+
+// Casts a column range by edge finding and face interpolation
+int castRaysAdaptive(int start, int end);
+
+// Bakes the first hit of every position and angle bucket of the map
+void buildRayTable(void);
+
+// Frees the baked ray table
+void freeRayTable(void);
+
+// Tells whether a baked ray table is in use
+bool rayTableReady(void);
+
+// Resolves a player ray from the baked table, false if it must be walked
+bool lookupRayTable(rayWalk_t *walk);
+
+// Picks the widest SIMD ray packet the CPU supports
+void initRayPackets(void);
+
+// Casts whole packets from start, returns the first column left uncast
+int castRayPackets(int start, int end);
+
 // Renders the rays on the screen
 void renderRays(void);
 
-// Calculates the intersection of horizontal rays
-void horizontalIntersection(float rayAngle);
+/* G-Buffer */
+
+// Structure-of-arrays record of the wall hits of every column, written by
+// the cast stage. Layer 0 is the opaque hit, layers 1 to layers[x] the
+// see-through hits in front of it, front to back. depth[0] is the depth
+// buffer later passes test against.
+typedef struct {
+    float depth[GBUFFER_LAYERS][NUM_RAYS];         // Perpendicular distance in pixels
+    fixed_t depthFx[GBUFFER_LAYERS][NUM_RAYS];     // The same in tiles, fixed point mode
+    int32_t stripHeight[GBUFFER_LAYERS][NUM_RAYS]; // Unclipped strip height
+    int16_t stripTop[GBUFFER_LAYERS][NUM_RAYS];    // First row of the clipped strip
+    int16_t stripBottom[GBUFFER_LAYERS][NUM_RAYS]; // One past its last row
+    uint8_t texU[GBUFFER_LAYERS][NUM_RAYS];        // Texture column in tile units
+    uint8_t material[GBUFFER_LAYERS][NUM_RAYS];    // Cell content (texture ID + 1)
+    uint8_t side[GBUFFER_LAYERS][NUM_RAYS];        // 1 for vertical grid line hits
+    uint8_t layers[NUM_RAYS];                      // See-through layers in use
+} gbuffer_t;
+
+extern gbuffer_t gbuffer; // Wall hits of the current frame
+
+// Projects the cast rays of columns [start, end) into the G-buffer
+void writeGBuffer(int start, int end);
+
+/* Camera Tables */
+
+// Struct holding values that only change with the field of view
+typedef struct {
+    bool ready;                        // Whether the tables were built
+    float fov;                         // Field of view the tables were built for
+    float eyeHeight;                   // Eye height the row distances were built for
+    float projPlane;                   // Distance to the projection plane
+    float columnAngle[NUM_RAYS];       // Ray angle offset of each column
+    float columnCos[NUM_RAYS];         // Fisheye correction of each column
+    float rowDistance[SCREEN_HEIGHT];  // Perpendicular floor distance of each row
+} camera_t;
+
+extern camera_t camera; // Global camera tables
+
+// Rebuilds the camera tables when the field of view or eye height changes
+void updateCamera(float fov, float eyeHeight);
+
+// Player pose a frame is cast and drawn from
+typedef struct {
+    float x;               // X coordinate of the eye
+    float y;               // Y coordinate of the eye
+    float angle;           // View direction in radians
+} camera_pose_t;
+
+extern camera_pose_t view; // Pose of the frame being rendered
+
+/* Frame Pipeline */
+
+// Starts the render thread when more than one frame may be in flight
+bool initPipeline(void);
+
+// Renders the current player pose and presents the oldest finished frame
+void submitFrame(void);
+
+// Presents the frames still in flight and stops the render thread
+void destroyPipeline(void);
+
+/* Fixed Point Engine */
+
+// Builds the trig and per-column tables of the fixed point engine
+void initFixedTables(void);
 
-// Calculates the intersection of vertical rays
-void verticalIntersection(float rayAngle);
+// Converts radians to a binary angle of ANGLE_STEPS per turn
+int toBinaryAngle(float radians);
+
+// Sine of a binary angle in 16.16
+fixed_t fixedSin(int angle);
+
+// Cosine of a binary angle in 16.16
+fixed_t fixedCos(int angle);
+
+// DDA state of a fixed point ray, distances in tiles (16.16)
+typedef struct {
+    fixed_t dirX;         // X component of the ray direction
+    fixed_t dirY;         // Y component of the ray direction
+    int64_t deltaDistX;   // Ray length between two vertical grid lines
+    int64_t deltaDistY;   // Ray length between two horizontal grid lines
+    int64_t sideDistX;    // Ray length to the next vertical grid line
+    int64_t sideDistY;    // Ray length to the next horizontal grid line
+    int64_t distance;     // Ray length to the last crossed grid line
+    int mapX;             // Current cell column
+    int mapY;             // Current cell row
+    int stepX;            // Column step (-1 or 1)
+    int stepY;            // Row step (-1 or 1)
+    bool vertical;        // Whether the last crossed grid line was vertical
+    int content;          // Content of the current cell
+} fixedWalk_t;
+
+// Captures the player view in fixed point before casting
+void beginFixedFrame(void);
+
+// Casts the ray of a column with integer arithmetic
+void castRayFixed(int col);
+
+// Projected wall strip height for a fixed point perpendicular distance
+int fixedWallHeight(fixed_t perpDistance);
+
+// World position of a floor or ceiling row at column 0 and its per-column step
+typedef struct {
+    float x;               // X in pixels, float mode
+    float y;               // Y in pixels, float mode
+    float stepX;           // X step per column in pixels, float mode
+    float stepY;           // Y step per column in pixels, float mode
+    int64_t xFx;           // X in tiles with 32 fraction bits, fixed point mode
+    int64_t yFx;           // Y in tiles with 32 fraction bits, fixed point mode
+    int64_t stepXFx;       // X step per column, fixed point mode
+    int64_t stepYFx;       // Y step per column, fixed point mode
+} plane_row_t;
+
+// Distance along the view direction to the floor or ceiling of a row, in tiles
+fixed_t fixedRowDistance(int y);
+
+// Fills the fixed point world position of a floor or ceiling row
+void fixedPlaneRow(fixed_t distance, plane_row_t *row);
 
 /* Texture Structure and Functions */
 
@@ -163,20 +541,81 @@ void verticalIntersection(float rayAngle);
 typedef struct {
     int width;          // Width of the texture
     int height;         // Height of the texture
-    color_t *textureBuffer; // Pointer to the texture data
+    color_t *texture_buffer; // Pointer to the texture data
     upng_t *upngTexture;    // Pointer to the UPNG texture data
 } Texture;
 
-Texture wallTextures[NUM_TEXTURES]; // Array of wall textures
+// Where a texture lives in the atlas; sizes are powers of two
+typedef struct {
+    uint32_t texels;       // Offset of the row-major texels
+    uint32_t mips[2][MAX_MIP_LEVELS]; // Offsets of the column-major mip levels, plain and shaded
+    uint8_t widthShift;    // log2 of the width
+    uint8_t heightShift;   // log2 of the height
+    uint8_t mipLevels;     // Levels in each mip chain, 0 if the texture is missing
+} texture_desc_t;
+
+// Returns log2 of a texture size at a mip level
+static inline int mipShift(int shift, int level)
+{
+    return (shift > level ? shift - level : 0);
+}
+
+extern Texture wallTextures[NUM_TEXTURES]; // Array of wall textures
+extern color_t *textureAtlas;                // Texels of every texture, cache line aligned
+extern texture_desc_t textureDescs[NUM_TEXTURES]; // Atlas descriptor of each texture
 
 // Loads wall textures from files
-void loadWallTextures(void);
+void WallTexturesready(void);
 
 // Frees memory associated with wall textures
 void freeWallTextures(void);
 
+/* Shading */
+
+// Per channel color tables of one fog level, each entry already shifted
+typedef struct {
+    color_t channel[3][256];
+} shade_lut_t;
+
+// Fills the shaded mip chains and builds the fog tables
+void initShading(void);
+
+// Returns the fog table for a distance in pixels, or NULL when fog is off
+const shade_lut_t *fogTable(float distance);
+
+// Returns the fog table for a fixed point distance in tiles, or NULL
+const shade_lut_t *fogTableFixed(fixed_t distance);
+
+// Applies a fog table to a strided run of pixels
+void fogSpan(color_t *pixels, int count, int stride, const shade_lut_t *lut);
+
+// Looks a texel up in a fog table, keeping alpha
+static inline color_t fogTexel(const shade_lut_t *lut, color_t texel)
+{
+    return ((texel & 0xFF000000) | lut->channel[2][(texel >> 16) & 0xFF]
+            | lut->channel[1][(texel >> 8) & 0xFF] | lut->channel[0][texel & 0xFF]);
+}
+
 /* Wall Rendering Functions */
 
+// One wall strip for a span kernel; the strides follow the kernel
+typedef struct {
+    const color_t *src;    // First texel of the column-major texture column
+    color_t *dst;          // First pixel of the screen span
+    fixed_t v;             // Texture row of the first pixel (16.16)
+    fixed_t step;          // Texture rows per screen pixel (16.16)
+    const shade_lut_t *fog; // Fog table of the strip distance, NULL for none
+} column_span_t;
+
+// Span kernel drawing count pixels of a wall strip
+typedef void (*column_kernel_t)(const column_span_t *span, int count);
+
+// Picks the span kernel for the fog and transparency of a strip
+column_kernel_t getColumnKernel(bool fog, bool masked);
+
+// Prints the throughput of every span kernel variant
+void benchWallKernels(void);
+
 // Renders walls based on raycasted data
 void renderWall(void);
 
@@ -0,0 +1,98 @@
+#include "../headers/header.h"
+
+static const char *stageNames[BENCH_NUM_STAGES] = {
+	"cast",
+	"render",
+	"present",
+	"frame",
+};
+
+static const char *counterNames[BENCH_NUM_COUNTERS] = {
+	"ray hits",
+	"rays cast",
+	"plane texels",
+};
+
+static Uint64 stageStart[BENCH_NUM_STAGES];
+static Uint64 stageTotal[BENCH_NUM_STAGES];
+static long counterTotal[BENCH_NUM_COUNTERS];
+static int framesTimed;
+
+/**
+ * benchStart - start timing a frame stage
+ * @stage: stage to time
+ *
+ * Only does anything when MAZE_BENCH is set. The totals are not locked,
+ * so each stage and counter must stay with a single thread. With
+ * MAZE_PIPELINE above 1, BENCH_CAST, BENCH_RENDER and benchCount run on
+ * the render thread, while BENCH_PRESENT, BENCH_FRAME and benchFrameDone
+ * run on the main thread; otherwise all of them run on the main thread.
+ * This is only race free while the two sets stay disjoint. benchReport
+ * reads everything after destroyPipeline has joined the render thread.
+*/
+
+void benchStart(bench_stage_t stage)
+{
+	if (config.benchFrames > 0)
+		stageStart[stage] = SDL_GetPerformanceCounter();
+}
+
+/**
+ * benchStop - stop timing a frame stage
+ * @stage: stage being timed
+ *
+*/
+
+void benchStop(bench_stage_t stage)
+{
+	if (config.benchFrames > 0)
+		stageTotal[stage] += SDL_GetPerformanceCounter() - stageStart[stage];
+}
+
+/**
+ * benchCount - add to a frame counter
+ * @counter: counter to increase
+ * @amount: value to add
+ *
+*/
+
+void benchCount(bench_counter_t counter, int amount)
+{
+	if (config.benchFrames > 0)
+		counterTotal[counter] += amount;
+}
+
+/**
+ * benchFrameDone - account for a finished frame
+ * Return: false once the requested number of frames was timed
+*/
+
+bool benchFrameDone(void)
+{
+	return (config.benchFrames <= 0 || ++framesTimed < config.benchFrames);
+}
+
+/**
+ * benchReport - print the per-frame averages of the timed frames
+ *
+*/
+
+void benchReport(void)
+{
+	double frequency = (double)SDL_GetPerformanceFrequency();
+	int i;
+
+	if (framesTimed == 0)
+		return;
+
+	printf("%d frames at %dx%d, %d threads, present: %s\n", framesTimed,
+		   SCREEN_WIDTH, SCREEN_HEIGHT, config.numThreads, getPresentName());
+	for (i = 0; i < BENCH_NUM_STAGES; i++)
+		printf("  %-12s %9.3f ms/frame\n", stageNames[i],
+			   stageTotal[i] * 1000.0 / frequency / framesTimed);
+	for (i = 0; i < BENCH_NUM_COUNTERS; i++)
+		printf("  %-12s %9.1f /frame\n", counterNames[i],
+			   (double)counterTotal[i] / framesTimed);
+	printf("wall span kernels:\n");
+	benchWallKernels();
+}
@@ -0,0 +1,43 @@
+#include "../headers/header.h"
+
+camera_t camera;
+camera_pose_t view;
+
+/**
+ * updateCamera - rebuild the per-column and per-row camera tables
+ * @fov: horizontal field of view in radians
+ * @eyeHeight: height of the eye above the floor
+ *
+ * The tables only depend on the field of view, the eye height and the
+ * compile time resolution, so this is a no-op while neither changes.
+*/
+
+void updateCamera(float fov, float eyeHeight)
+{
+	int col, y;
+
+	if (camera.ready && camera.fov == fov && camera.eyeHeight == eyeHeight)
+		return;
+
+	camera.fov = fov;
+	camera.eyeHeight = eyeHeight;
+	camera.projPlane = (SCREEN_WIDTH / 2) / tan(fov / 2);
+
+	for (col = 0; col < NUM_RAYS; col++)
+	{
+		camera.columnAngle[col] = atan((col - NUM_RAYS / 2) / camera.projPlane);
+		camera.columnCos[col] = cos(camera.columnAngle[col]);
+	}
+
+	for (y = 0; y < SCREEN_HEIGHT; y++)
+	{
+		if (y == SCREEN_HEIGHT / 2)
+			camera.rowDistance[y] = 0;
+		else
+			camera.rowDistance[y] = (eyeHeight / (y - SCREEN_HEIGHT / 2))
+									* camera.projPlane;
+	}
+
+	initFixedTables();
+	camera.ready = true;
+}
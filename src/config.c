@@ -0,0 +1,49 @@
+#include "../headers/header.h"
+
+config_t config;
+
+/**
+ * getEnvInt - read an integer setting from the environment
+ * @name: environment variable name
+ * @fallback: value used when the variable is unset
+ * Return: the parsed value or fallback
+*/
+
+static int getEnvInt(const char *name, int fallback)
+{
+	const char *value = SDL_getenv(name);
+
+	return (value != NULL && *value != '\0' ? SDL_atoi(value) : fallback);
+}
+
+/**
+ * loadConfig - fill the runtime configuration from the environment
+ *
+*/
+
+void loadConfig(void)
+{
+	config.numThreads = getEnvInt("MAZE_THREADS", 0);
+	if (config.numThreads <= 0)
+		config.numThreads = SDL_GetCPUCount();
+	if (config.numThreads > MAX_WORKERS)
+		config.numThreads = MAX_WORKERS;
+	config.simdRays = getEnvInt("MAZE_SIMD", 1) != 0;
+	config.fixedPoint = getEnvInt("MAZE_FIXED", 0) != 0;
+	config.adaptiveStep = getEnvInt("MAZE_ADAPTIVE", 0);
+	config.rayTableBytes = (size_t)getEnvInt("MAZE_RAY_TABLE_MB", 0) << 20;
+	config.benchFrames = getEnvInt("MAZE_BENCH", 0);
+	config.fogDistance = getEnvInt("MAZE_FOG", 0);
+	config.columnMajor = getEnvInt("MAZE_COLUMN_MAJOR", 0) != 0;
+	config.bufferedPresent = getEnvInt("MAZE_BUFFERED", 0) != 0;
+	config.halfRateTiles = getEnvInt("MAZE_HALF_RATE", 0);
+	config.quarterRateTiles = getEnvInt("MAZE_QUARTER_RATE", 0);
+	config.presentMode = getEnvInt("MAZE_PRESENT", PRESENT_RENDERER);
+	if (config.presentMode < PRESENT_RENDERER || config.presentMode > PRESENT_SCALED)
+		config.presentMode = PRESENT_RENDERER;
+	config.pipelineDepth = getEnvInt("MAZE_PIPELINE", 1);
+	if (config.pipelineDepth < 1)
+		config.pipelineDepth = 1;
+	if (config.pipelineDepth > MAX_PIPELINE_DEPTH)
+		config.pipelineDepth = MAX_PIPELINE_DEPTH;
+}
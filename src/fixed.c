@@ -0,0 +1,319 @@
+#include "../headers/header.h"
+
+/* pi / 2 in 2.30 fixed point */
+#define HALF_PI_Q30 1686629713LL
+/* Ray length used for an axis the ray never crosses */
+#define FIXED_FAR ((int64_t)1 << 46)
+
+static fixed_t sineTable[ANGLE_STEPS];
+static fixed_t columnRatio[NUM_RAYS];
+static fixed_t rowDistanceFx[SCREEN_HEIGHT];
+static fixed_t projPlaneFx;
+
+static fixed_t viewX, viewY, viewDirX, viewDirY;
+
+/**
+ * fixedSineQuadrant - sine of a first quadrant binary angle
+ * @step: angle in [0, ANGLE_STEPS / 4]
+ * Return: the sine in 16.16
+ *
+ * Evaluated as a Taylor series in 2.30 integers so every build and
+ * every platform produces the exact same table.
+*/
+
+static fixed_t fixedSineQuadrant(int step)
+{
+	int64_t x = HALF_PI_Q30 * step / (ANGLE_STEPS / 4);
+	int64_t x2 = (x * x) >> 30;
+	int64_t term = x, sum = x;
+	int k;
+
+	for (k = 1; k <= 6; k++)
+	{
+		term = -((term * x2) >> 30) / ((2 * k) * (2 * k + 1));
+		sum += term;
+	}
+	return ((fixed_t)((sum + (1 << 13)) >> 14));
+}
+
+/**
+ * fixedSin - sine of a binary angle
+ * @angle: angle in ANGLE_STEPS per turn, any value
+ * Return: the sine in 16.16
+*/
+
+fixed_t fixedSin(int angle)
+{
+	return (sineTable[angle & (ANGLE_STEPS - 1)]);
+}
+
+/**
+ * fixedCos - cosine of a binary angle
+ * @angle: angle in ANGLE_STEPS per turn, any value
+ * Return: the cosine in 16.16
+*/
+
+fixed_t fixedCos(int angle)
+{
+	return (sineTable[(angle + ANGLE_STEPS / 4) & (ANGLE_STEPS - 1)]);
+}
+
+/**
+ * toBinaryAngle - convert radians to ANGLE_STEPS per turn
+ * @radians: angle in radians
+ * Return: the binary angle wrapped to [0, ANGLE_STEPS)
+*/
+
+int toBinaryAngle(float radians)
+{
+	return ((int)floorf(radians * (ANGLE_STEPS / TWO_PI)) & (ANGLE_STEPS - 1));
+}
+
+/**
+ * initFixedTables - build the fixed point trig and camera tables
+ *
+ * Called by updateCamera whenever the field of view changes.
+*/
+
+void initFixedTables(void)
+{
+	int i, halfFov;
+	fixed_t eyeHeight;
+
+	for (i = 0; i <= ANGLE_STEPS / 4; i++)
+	{
+		fixed_t s = fixedSineQuadrant(i);
+
+		sineTable[i] = s;
+		sineTable[ANGLE_STEPS / 2 - i] = s;
+		sineTable[(ANGLE_STEPS / 2 + i) & (ANGLE_STEPS - 1)] = -s;
+		sineTable[(ANGLE_STEPS - i) & (ANGLE_STEPS - 1)] = -s;
+	}
+
+	halfFov = toBinaryAngle(camera.fov / 2);
+	projPlaneFx = (fixed_t)(((int64_t)(SCREEN_WIDTH / 2) * fixedCos(halfFov)
+					<< FIXED_SHIFT) / fixedSin(halfFov));
+	for (i = 0; i < NUM_RAYS; i++)
+		columnRatio[i] = (fixed_t)((int64_t)(i - NUM_RAYS / 2)
+					* ((int64_t)1 << (2 * FIXED_SHIFT)) / projPlaneFx);
+	eyeHeight = (fixed_t)(camera.eyeHeight * FIXED_ONE);
+	for (i = 0; i < SCREEN_HEIGHT; i++)
+		rowDistanceFx[i] = i == SCREEN_HEIGHT / 2 ? 0
+			: (fixed_t)(((int64_t)eyeHeight * projPlaneFx
+			/ ((int64_t)abs(i - SCREEN_HEIGHT / 2) * TILE_SIZE)) >> FIXED_SHIFT);
+}
+
+/**
+ * beginFixedFrame - snapshot the player view in fixed point
+ *
+ * Positions are kept in tiles so 16.16 covers maps up to 32767 tiles.
+*/
+
+void beginFixedFrame(void)
+{
+	int angle = toBinaryAngle(view.angle);
+
+	viewX = (fixed_t)(view.x * (FIXED_ONE / TILE_SIZE));
+	viewY = (fixed_t)(view.y * (FIXED_ONE / TILE_SIZE));
+	viewDirX = fixedCos(angle);
+	viewDirY = fixedSin(angle);
+}
+
+/**
+ * fixedWallHeight - projected height of a wall strip
+ * @perpDistance: perpendicular distance in tiles, 16.16
+ * Return: the strip height in pixels
+*/
+
+int fixedWallHeight(fixed_t perpDistance)
+{
+	return (projPlaneFx / perpDistance);
+}
+
+/**
+ * skipEmptyCellsFixed - jump a fixed point walk across the empty box
+ * around its cell
+ * @walk: walk currently in an empty cell
+ * @radius: empty radius of that cell, at least 2
+ *
+ * Same jump as skipEmptyCells. Side distances are exact sums, so the
+ * walk ends up where stepping cell by cell would have taken it.
+*/
+
+static void skipEmptyCellsFixed(fixedWalk_t *walk, int radius)
+{
+	int64_t exitX = walk->sideDistX + (radius - 1) * walk->deltaDistX;
+	int64_t exitY = walk->sideDistY + (radius - 1) * walk->deltaDistY;
+	int64_t exitDist = exitX < exitY ? exitX : exitY;
+	int stepsX = 0, stepsY = 0;
+
+	if (walk->sideDistX < exitDist)
+		stepsX = (int)((exitDist - walk->sideDistX + walk->deltaDistX - 1)
+			/ walk->deltaDistX);
+	if (walk->sideDistY < exitDist)
+		stepsY = (int)((exitDist - walk->sideDistY + walk->deltaDistY - 1)
+			/ walk->deltaDistY);
+	stepsX = stepsX > radius - 1 ? radius - 1 : stepsX;
+	stepsY = stepsY > radius - 1 ? radius - 1 : stepsY;
+
+	walk->sideDistX += stepsX * walk->deltaDistX;
+	walk->sideDistY += stepsY * walk->deltaDistY;
+	walk->mapX += stepsX * walk->stepX;
+	walk->mapY += stepsY * walk->stepY;
+}
+
+/**
+ * walkRayFixed - step a fixed point walk to the next solid cell
+ * @walk: walk to advance, stopped on the hit cell or outside the map
+ *
+ * Open areas are crossed in one jump using the map's empty radius.
+*/
+
+static void walkRayFixed(fixedWalk_t *walk)
+{
+	while (walk->content == 0)
+	{
+		int radius = getEmptyRadius(walk->mapY, walk->mapX);
+
+		if (radius > 1)
+			skipEmptyCellsFixed(walk, radius);
+		if (walk->sideDistX < walk->sideDistY)
+		{
+			walk->distance = walk->sideDistX;
+			walk->sideDistX += walk->deltaDistX;
+			walk->mapX += walk->stepX;
+			walk->vertical = true;
+		}
+		else
+		{
+			walk->distance = walk->sideDistY;
+			walk->sideDistY += walk->deltaDistY;
+			walk->mapY += walk->stepY;
+			walk->vertical = false;
+		}
+		if (walk->mapX < 0 || walk->mapX >= MAP_NUM_COLS
+			|| walk->mapY < 0 || walk->mapY >= MAP_NUM_ROWS)
+			break;
+		if (isCellSolid(walk->mapY, walk->mapX))
+			walk->content = getMapValue(walk->mapY, walk->mapX);
+	}
+}
+
+/**
+ * fillFixedHit - describe the cell a fixed point walk stopped on
+ * @ray: hit record to fill
+ * @walk: walk stopped on the hit cell
+ *
+ * Only the fields the fixed point renderer and the minimap read are
+ * filled; rayAngle and distance are left alone.
+*/
+
+static void fillFixedHit(ray_t *ray, const fixedWalk_t *walk)
+{
+	int64_t distance = walk->distance;
+	fixed_t perp, hitX, hitY;
+
+	perp = distance < 1 ? 1 : distance > INT32_MAX ? INT32_MAX : (fixed_t)distance;
+	if (walk->vertical)
+	{
+		hitX = (walk->stepX > 0 ? walk->mapX : walk->mapX + 1) << FIXED_SHIFT;
+		hitY = viewY + FIXED_MUL(perp, walk->dirY);
+		ray->textureOffsetX = ((hitY & FIXED_FRAC) * TILE_SIZE) >> FIXED_SHIFT;
+	}
+	else
+	{
+		hitX = viewX + FIXED_MUL(perp, walk->dirX);
+		hitY = (walk->stepY > 0 ? walk->mapY : walk->mapY + 1) << FIXED_SHIFT;
+		ray->textureOffsetX = ((hitX & FIXED_FRAC) * TILE_SIZE) >> FIXED_SHIFT;
+	}
+
+	ray->perpDistanceFx = perp;
+	ray->wasHitVertical = walk->vertical;
+	ray->wallHitContent = walk->content;
+	ray->mapX = walk->mapX;
+	ray->mapY = walk->mapY;
+
+	/* float copies for the minimap and the floor and ceiling passes */
+	ray->wallHitX = hitX * ((float)TILE_SIZE / FIXED_ONE);
+	ray->wallHitY = hitY * ((float)TILE_SIZE / FIXED_ONE);
+	ray->perpDistance = perp * ((float)TILE_SIZE / FIXED_ONE);
+}
+
+/**
+ * fixedRowDistance - distance to the floor or ceiling seen on a row
+ * @y: screen row
+ * Return: the distance along the view direction in tiles, 16.16
+*/
+
+fixed_t fixedRowDistance(int y)
+{
+	return (rowDistanceFx[y]);
+}
+
+/**
+ * fixedPlaneRow - world position of a floor or ceiling row in fixed point
+ * @distance: distance to the row along the view direction, in tiles
+ * @row: filled with the position at column 0 and the per-column step
+ *
+ * Positions get 32 fraction bits so the step does not drift across a
+ * row, with no float operation a compiler could fuse differently.
+*/
+
+void fixedPlaneRow(fixed_t distance, plane_row_t *row)
+{
+	int64_t ratio = ((int64_t)distance << 32) / projPlaneFx;
+
+	row->stepXFx = -((int64_t)viewDirY * ratio) >> FIXED_SHIFT;
+	row->stepYFx = ((int64_t)viewDirX * ratio) >> FIXED_SHIFT;
+	row->xFx = (int64_t)viewX * FIXED_ONE + (int64_t)viewDirX * distance
+		- row->stepXFx * (NUM_RAYS / 2);
+	row->yFx = (int64_t)viewY * FIXED_ONE + (int64_t)viewDirY * distance
+		- row->stepYFx * (NUM_RAYS / 2);
+}
+
+/**
+ * castRayFixed - cast the ray of a column with integer arithmetic only
+ * @col: screen column
+ *
+ * The ray direction is the view direction plus the camera plane offset
+ * of the column, so the DDA length is already the perpendicular
+ * distance and needs no fisheye correction. See-through cells are
+ * recorded in rayHits and the walk carries on behind them, as castRay
+ * does.
+*/
+
+void castRayFixed(int col)
+{
+	fixedWalk_t walk;
+	int numHits = 0;
+
+	walk.dirX = viewDirX - FIXED_MUL(viewDirY, columnRatio[col]);
+	walk.dirY = viewDirY + FIXED_MUL(viewDirX, columnRatio[col]);
+	walk.mapX = viewX >> FIXED_SHIFT;
+	walk.mapY = viewY >> FIXED_SHIFT;
+	walk.stepX = walk.dirX < 0 ? -1 : 1;
+	walk.stepY = walk.dirY < 0 ? -1 : 1;
+	walk.distance = 0;
+	walk.vertical = false;
+	walk.content = 0;
+	walk.deltaDistX = walk.dirX ? ((int64_t)1 << (2 * FIXED_SHIFT))
+		/ (walk.dirX < 0 ? -walk.dirX : walk.dirX) : FIXED_FAR;
+	walk.deltaDistY = walk.dirY ? ((int64_t)1 << (2 * FIXED_SHIFT))
+		/ (walk.dirY < 0 ? -walk.dirY : walk.dirY) : FIXED_FAR;
+	walk.sideDistX = ((int64_t)(walk.dirX < 0 ? viewX & FIXED_FRAC
+				: FIXED_ONE - (viewX & FIXED_FRAC)) * walk.deltaDistX) >> FIXED_SHIFT;
+	walk.sideDistY = ((int64_t)(walk.dirY < 0 ? viewY & FIXED_FRAC
+				: FIXED_ONE - (viewY & FIXED_FRAC)) * walk.deltaDistY) >> FIXED_SHIFT;
+
+	walkRayFixed(&walk);
+	/* keep going through see-through cells, remembering the first ones */
+	while (walk.content != 0 && isSeeThrough(walk.content))
+	{
+		if (numHits < MAX_RAY_HITS)
+			fillFixedHit(&rayHits[col][numHits++], &walk);
+		walk.content = 0;
+		walkRayFixed(&walk);
+	}
+	fillFixedHit(&rays[col], &walk);
+	rays[col].numHits = numHits;
+}
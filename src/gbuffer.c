@@ -0,0 +1,70 @@
+#include "../headers/header.h"
+
+gbuffer_t gbuffer;
+
+/**
+ * projectWall - compute the screen strip of a wall hit
+ * @ray: wall hit
+ * @wallTopPixel: first row of the clipped strip
+ * @wallBottomPixel: one past the last row of the clipped strip
+ * Return: the unclipped strip height
+*/
+
+static int projectWall(const ray_t *ray, int *wallTopPixel, int *wallBottomPixel)
+{
+	int wallStripHeight;
+
+	if (config.fixedPoint)
+		wallStripHeight = fixedWallHeight(ray->perpDistanceFx);
+	else
+		wallStripHeight = (int)((TILE_SIZE / ray->perpDistance) * camera.projPlane);
+	*wallTopPixel = (SCREEN_HEIGHT / 2) - (wallStripHeight / 2);
+	*wallTopPixel = *wallTopPixel < 0 ? 0 : *wallTopPixel;
+	*wallBottomPixel = (SCREEN_HEIGHT / 2) + (wallStripHeight / 2);
+	*wallBottomPixel = *wallBottomPixel > SCREEN_HEIGHT
+						? SCREEN_HEIGHT : *wallBottomPixel;
+	return (wallStripHeight);
+}
+
+/**
+ * writeLayer - store one wall hit in a G-buffer layer
+ * @layer: layer to write
+ * @x: screen column
+ * @ray: wall hit
+*/
+
+static void writeLayer(int layer, int x, const ray_t *ray)
+{
+	int wallTopPixel, wallBottomPixel;
+
+	gbuffer.stripHeight[layer][x] = projectWall(ray, &wallTopPixel,
+												&wallBottomPixel);
+	gbuffer.stripTop[layer][x] = wallTopPixel;
+	gbuffer.stripBottom[layer][x] = wallBottomPixel;
+	gbuffer.depth[layer][x] = ray->perpDistance;
+	if (config.fixedPoint)
+		gbuffer.depthFx[layer][x] = ray->perpDistanceFx;
+	gbuffer.texU[layer][x] = ray->textureOffsetX;
+	gbuffer.material[layer][x] = ray->wallHitContent;
+	gbuffer.side[layer][x] = ray->wasHitVertical;
+}
+
+/**
+ * writeGBuffer - project the cast rays of a range of columns into the
+ * G-buffer
+ * @start: first column
+ * @end: one past the last column
+*/
+
+void writeGBuffer(int start, int end)
+{
+	int x, i;
+
+	for (x = start; x < end; x++)
+	{
+		writeLayer(0, x, &rays[x]);
+		for (i = 0; i < rays[x].numHits; i++)
+			writeLayer(i + 1, x, &rayHits[x][i]);
+		gbuffer.layers[x] = rays[x].numHits;
+	}
+}
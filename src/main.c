@@ -12,8 +12,8 @@ player_t player;           // Player structure instance
  */
 void setup_game(void)
 {
-    player.x = SCREEN_WIDTH / 2;           // Start player in the center of the screen
-    player.y = SCREEN_HEIGHT / 2;
+    player.x = MAP_NUM_COLS * TILE_SIZE / 2; // Start player in the center of the map
+    player.y = MAP_NUM_ROWS * TILE_SIZE / 2;
     player.width = 1;                       // Player width (for collision)
     player.height = 30;                     // Player height
     player.walkDirection = 0;               // Initial walking direction (stationary)
@@ -21,15 +21,24 @@ void setup_game(void)
     player.turnDirection = 0;                // Initial turning direction (stationary)
     player.turnSpeed = 45 * (PI / 180);     // Turning speed in radians
     player.rotationAngle = PI / 2;          // Initial facing direction (pointing upwards)
+    if (config.benchFrames > 0)
+        player.turnDirection = 1;           // Sweep the view while benchmarking
     WallTexturesready();                     // Load wall textures for rendering
+    initShading();                           // Shade textures and build fog tables
+    prepareMap();                            // Build the map acceleration data
+    initRayPackets();                        // Pick the SIMD ray caster
+    updateCamera(FOV_ANGLE, player.height);  // Build the camera tables
+    initWorkers(config.numThreads);          // Start the ray casting threads
+    buildRayTable();                         // Bake the ray table if enabled
+    initPipeline();                          // Start the render thread if enabled
 }
 
 /**
- * update_game - Updates game state including delta time, player movement,
- *               and ray casting for visibility calculations.
+ * update_game - Updates game state including delta time and player movement.
  *
  * This function calculates the time elapsed since the last frame,
- * manages frame rate, and updates player position and raycasting.
+ * manages frame rate, and updates player position. Rays are cast when
+ * the frame is rendered, from a copy of the player pose.
  */
 void update_game(void)
 {
@@ -37,34 +46,37 @@ void update_game(void)
     int timeToWait = FRAME_TIME_LENGTH - (SDL_GetTicks() - TicksLastFrame); // Frame timing
 
     // Delay if necessary to maintain consistent frame rate
-    if (timeToWait > 0 && timeToWait <= FRAME_TIME_LENGTH)
+    if (timeToWait > 0 && timeToWait <= FRAME_TIME_LENGTH && config.benchFrames <= 0)
     {
         SDL_Delay(timeToWait);
     }
 
     DeltaTime = (SDL_GetTicks() - TicksLastFrame) / 1000.0f; // Calculate delta time in seconds
     TicksLastFrame = SDL_GetTicks(); // Update last frame tick count
+    if (config.benchFrames > 0)
+        DeltaTime = 1.0f / FPS; // Same motion every run when benchmarking
 
     movePlayer(DeltaTime); // Update player position based on input
-    castAllRays();         // Cast rays for rendering visibility
 }
 
 /**
- * render_game - Calls rendering functions to display the game on screen.
+ * render_game - Calls rendering functions to draw a frame.
  *
- * This function clears the screen, renders walls, the map,
- * rays, and the player, then updates the display buffer.
+ * This function casts rays from the camera pose, then renders walls, the
+ * map, rays, and the player into the current framebuffer. The wall pass
+ * writes every pixel, so the screen is not cleared first. It runs on the
+ * render thread when the frame pipeline is enabled.
  */
 void render_game(void)
 {
-    clearColorBuffer(0xFF000000); // Clear the screen with a black color
+    castAllRays(); // Cast rays for rendering visibility
 
-    renderWall();  // Render wall textures
+    benchStart(BENCH_RENDER);
+    renderWall();  // Render walls, floor and ceiling over every pixel
     renderMap();   // Render the game map
     renderRays();  // Render rays for visibility
     renderPlayer(); // Render the player
-
-    renderColorBuffer(); // Present the rendered frame to the screen
+    benchStop(BENCH_RENDER);
 }
 
 /**
@@ -75,6 +87,11 @@ void render_game(void)
  */
 void destroy_game(void)
 {
+    destroyPipeline();  // Present the frames in flight
+    freeRayTable();     // Free the baked ray table
+    destroyWorkers();   // Stop the worker threads
+    benchReport();      // Print timings when benchmarking
+    overdrawReport();   // Print coverage totals in overdraw builds
     freeWallTextures(); // Free any loaded wall textures
     destroyWindow();    // Destroy the window and clean up SDL
 }
@@ -85,6 +102,7 @@ void destroy_game(void)
  */
 int main(void)
 {
+    loadConfig();                     // Read runtime settings
     GameRunning = initializeWindow(); // Initialize the game window
 
     setup_game(); // Set up initial game state
@@ -92,9 +110,12 @@ int main(void)
     // Main game loop
     while (GameRunning)
     {
+        benchStart(BENCH_FRAME);
         handleInput();  // Process user input
         update_game();  // Update game state
-        render_game();   // Render the current game state
+        submitFrame();  // Render the new state and present a finished frame
+        benchStop(BENCH_FRAME);
+        GameRunning = GameRunning && benchFrameDone(); // Stop after the timed frames
     }
     
     destroy_game(); // Clean up resources before exiting
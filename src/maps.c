@@ -4,19 +4,46 @@
 static const int map[MAP_NUM_ROWS][MAP_NUM_COLS] = {
     {6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6},
     {6, 0, 0, 0, 6, 0, 0, 0, 0, 0, 0, 6, 0, 0, 0, 0, 0, 0, 0, 6},
-    {6, 0, 0, 0, 0, 0, 1, 1, 1, 1, 0, 6, 0, 0, 0, 6, 0, 0, 0, 6},
+    {6, 0, 0, 0, 0, 0, 1, 1, 1, 1, 0, 9, 0, 0, 0, 6, 0, 0, 0, 6},
     {6, 0, 1, 0, 1, 0, 1, 0, 0, 1, 0, 6, 0, 7, 7, 0, 0, 0, 0, 6},
     {6, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 6, 0, 0, 0, 0, 0, 7, 0, 6},
     {6, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 7, 0, 6},
     {6, 0, 0, 0, 0, 0, 7, 7, 7, 0, 0, 1, 0, 0, 0, 0, 7, 7, 0, 6},
     {6, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 6},
     {6, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0, 0, 7, 0, 0, 0, 0, 1, 0, 6},
-    {6, 0, 0, 1, 0, 1, 1, 1, 0, 0, 0, 0, 7, 0, 0, 0, 0, 1, 0, 6},
+    {6, 0, 0, 1, 0, 1, 1, 1, 0, 9, 9, 0, 7, 0, 0, 0, 0, 1, 0, 6},
     {6, 0, 0, 6, 6, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 6},
     {6, 0, 0, 0, 6, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 6},
     {6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6}
 };
 
+// Flags of each cell content, indexed by texture ID
+static const uint8_t materialFlags[NUM_TEXTURES + 1] = {
+    0,  // 0: empty
+    0,  // 1: redbrick
+    0,  // 2: purplestone
+    0,  // 3: mossystone
+    0,  // 4: graystone
+    0,  // 5: colorstone
+    0,  // 6: bluestone
+    0,  // 7: wood
+    0,  // 8: eagle
+    MATERIAL_SEE_THROUGH // 9: grate
+};
+
+// Whether any cell of the map is see-through
+static bool seeThroughCells;
+
+// Chebyshev distance, in cells, from each cell to the nearest wall,
+// with a padding row so 32-bit gathers stay in bounds
+static uint8_t emptyRadius[MAP_NUM_ROWS + 1][MAP_NUM_COLS];
+
+// One bit per cell, set for walls, each row padded to whole words
+uint64_t occupancyPlane[MAP_NUM_ROWS][OCCUPANCY_ROW_WORDS];
+
+// Texture ID of each cell, padded so 32-bit gathers stay in bounds
+static uint8_t materialPlane[MAP_NUM_ROWS * MAP_NUM_COLS + 3];
+
 /**
  * DetectCollision - Checks for potential collisions with walls
  * during the player's movement.
@@ -29,17 +56,16 @@ bool DetectCollision(float x, float y)
 {
     int mapGridX, mapGridY;
 
-    // Check if the next position is outside the map boundaries
-    if (x < 0 || x >= MAP_NUM_COLS * TILE_SIZE || 
-        y < 0 || y >= MAP_NUM_ROWS * TILE_SIZE)
+    if (x < 0 || y < 0)
         return true; // Collision with the map boundary
 
-    // Calculate the grid indices based on tile size
-    mapGridX = floor(x / TILE_SIZE);
-    mapGridY = floor(y / TILE_SIZE);
+    // Truncation is floor for positive values, and tiles are a power of two
+    mapGridX = (int)x >> TILE_SHIFT;
+    mapGridY = (int)y >> TILE_SHIFT;
+    if (mapGridX >= MAP_NUM_COLS || mapGridY >= MAP_NUM_ROWS)
+        return true; // Collision with the map boundary
 
-    // Return true if the grid cell contains a wall (non-zero value)
-    return (map[mapGridY][mapGridX] != 0);
+    return (isCellSolid(mapGridY, mapGridX));
 }
 
 /**
@@ -64,7 +90,135 @@ bool isInsideMap(float x, float y)
  */
 int getMapValue(int row, int col)
 {
-    return (map[row][col]);
+    return (materialPlane[row * MAP_NUM_COLS + col]);
+}
+
+/**
+ * getMaterialPlane - Gives direct access to the cell texture IDs.
+ *
+ * Return: The map as MAP_NUM_ROWS * MAP_NUM_COLS row-major bytes,
+ * followed by 3 padding bytes.
+ */
+const uint8_t *getMaterialPlane(void)
+{
+    return (materialPlane);
+}
+
+/**
+ * relaxRadius - Lowers a cell's radius through one of its neighbours.
+ * @row: Row of the cell.
+ * @col: Column of the cell.
+ * @nRow: Row of the neighbour.
+ * @nCol: Column of the neighbour.
+ */
+static void relaxRadius(int row, int col, int nRow, int nCol)
+{
+    if (nRow < 0 || nRow >= MAP_NUM_ROWS || nCol < 0 || nCol >= MAP_NUM_COLS)
+        return;
+    if (emptyRadius[nRow][nCol] + 1 < emptyRadius[row][col])
+        emptyRadius[row][col] = emptyRadius[nRow][nCol] + 1;
+}
+
+/**
+ * prepareMap - Rebuilds the data derived from the map cells.
+ *
+ * Must be called whenever a map is loaded. Packs the cells into the
+ * occupancy and material planes, and computes, for every cell, the
+ * Chebyshev distance to the nearest wall with a two-pass chamfer sweep;
+ * cells beyond the map border count as walls.
+ */
+void prepareMap(void)
+{
+    int i, j, border;
+
+    SDL_memset(occupancyPlane, 0, sizeof(occupancyPlane));
+    SDL_memset(materialPlane, 0, sizeof(materialPlane));
+    seeThroughCells = false;
+    for (i = 0; i < MAP_NUM_ROWS; i++)
+    {
+        for (j = 0; j < MAP_NUM_COLS; j++)
+        {
+            materialPlane[i * MAP_NUM_COLS + j] = (uint8_t)map[i][j];
+            seeThroughCells |= isSeeThrough(map[i][j]);
+            if (map[i][j] != 0)
+                occupancyPlane[i][j >> 6] |= (uint64_t)1 << (j & 63);
+
+            border = i + 1;
+            border = j + 1 < border ? j + 1 : border;
+            border = MAP_NUM_ROWS - i < border ? MAP_NUM_ROWS - i : border;
+            border = MAP_NUM_COLS - j < border ? MAP_NUM_COLS - j : border;
+            border = border > UINT8_MAX ? UINT8_MAX : border;
+            emptyRadius[i][j] = map[i][j] != 0 ? 0 : border;
+        }
+    }
+
+    // Forward pass: neighbours above and to the left
+    for (i = 0; i < MAP_NUM_ROWS; i++)
+    {
+        for (j = 0; j < MAP_NUM_COLS; j++)
+        {
+            relaxRadius(i, j, i - 1, j - 1);
+            relaxRadius(i, j, i - 1, j);
+            relaxRadius(i, j, i - 1, j + 1);
+            relaxRadius(i, j, i, j - 1);
+        }
+    }
+
+    // Backward pass: neighbours below and to the right
+    for (i = MAP_NUM_ROWS - 1; i >= 0; i--)
+    {
+        for (j = MAP_NUM_COLS - 1; j >= 0; j--)
+        {
+            relaxRadius(i, j, i + 1, j + 1);
+            relaxRadius(i, j, i + 1, j);
+            relaxRadius(i, j, i + 1, j - 1);
+            relaxRadius(i, j, i, j + 1);
+        }
+    }
+}
+
+/**
+ * getEmptyRadius - Retrieves how far the empty space around a cell reaches.
+ * @row: Row index of the map.
+ * @col: Column index of the map.
+ *
+ * Return: r such that every cell within Chebyshev distance r - 1 is empty.
+ */
+int getEmptyRadius(int row, int col)
+{
+    return (emptyRadius[row][col]);
+}
+
+/**
+ * getRadiusPlane - Gives direct access to the empty radius of the cells.
+ *
+ * Return: The radii as MAP_NUM_ROWS * MAP_NUM_COLS row-major bytes,
+ * followed by at least 3 padding bytes.
+ */
+const uint8_t *getRadiusPlane(void)
+{
+    return (&emptyRadius[0][0]);
+}
+
+/**
+ * isSeeThrough - Checks whether rays continue past a cell content.
+ * @content: Texture ID of the cell.
+ *
+ * Return: true for see-through materials such as grates or glass.
+ */
+bool isSeeThrough(int content)
+{
+    return ((materialFlags[content] & MATERIAL_SEE_THROUGH) != 0);
+}
+
+/**
+ * mapHasSeeThrough - Checks whether the map has see-through cells.
+ *
+ * Return: true if at least one cell is see-through.
+ */
+bool mapHasSeeThrough(void)
+{
+    return (seeThroughCells);
 }
 
 /**
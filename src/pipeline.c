@@ -0,0 +1,153 @@
+#include "../headers/header.h"
+
+static SDL_Thread *renderThread;
+static SDL_sem *framesQueued, *framesRendered;
+static camera_pose_t poses[MAX_PIPELINE_DEPTH];
+static int framesSubmitted, framesPresented;
+static SDL_atomic_t stopping;
+
+/**
+ * renderSlot - cast and draw one frame into its pipeline slot
+ * @slot: pipeline slot of the frame
+ *
+*/
+
+static void renderSlot(int slot)
+{
+	view = poses[slot];
+	lockColorBuffer(slot);
+	render_game();
+}
+
+/**
+ * renderMain - body of the render thread
+ * @data: unused
+ *
+ * Frames are rendered in the order they were submitted, so the slot of
+ * each one follows from a count kept by this thread alone.
+ * Return: 0 when the pipeline is shut down
+*/
+
+static int renderMain(void *data)
+{
+	int frame;
+
+	(void)data;
+	for (frame = 0;; frame++)
+	{
+		SDL_SemWait(framesQueued);
+		if (SDL_AtomicGet(&stopping))
+			return (0);
+		renderSlot(frame % config.pipelineDepth);
+		SDL_SemPost(framesRendered);
+	}
+}
+
+/**
+ * presentOldest - wait for the oldest frame in flight and present it
+ *
+*/
+
+static void presentOldest(void)
+{
+	SDL_SemWait(framesRendered);
+	benchStart(BENCH_PRESENT);
+	renderColorBuffer(framesPresented % config.pipelineDepth);
+	benchStop(BENCH_PRESENT);
+	framesPresented++;
+}
+
+/**
+ * destroySemaphores - release the semaphores shared with the render thread
+ *
+*/
+
+static void destroySemaphores(void)
+{
+	if (framesRendered)
+		SDL_DestroySemaphore(framesRendered);
+	if (framesQueued)
+		SDL_DestroySemaphore(framesQueued);
+	framesRendered = NULL;
+	framesQueued = NULL;
+}
+
+/**
+ * initPipeline - start the render thread when frames may overlap
+ *
+ * With a depth of 1 frames are rendered and presented inline, which is
+ * also what is left when the thread cannot be started.
+ * Return: true in case of success, false if it fails
+*/
+
+bool initPipeline(void)
+{
+	framesSubmitted = 0;
+	framesPresented = 0;
+	SDL_AtomicSet(&stopping, 0);
+	if (config.pipelineDepth <= 1)
+		return (true);
+
+	framesQueued = SDL_CreateSemaphore(0);
+	framesRendered = SDL_CreateSemaphore(0);
+	if (framesQueued && framesRendered)
+		renderThread = SDL_CreateThread(renderMain, "render", NULL);
+	if (!renderThread)
+	{
+		fprintf(stderr, "Error creating render thread: %s\n", SDL_GetError());
+		destroySemaphores();
+		config.pipelineDepth = 1;
+		return (false);
+	}
+	return (true);
+}
+
+/**
+ * submitFrame - hand the current player pose to the renderer
+ *
+ * The pose is copied so the player can keep moving while the frame is
+ * drawn. Once pipelineDepth frames are unpresented the oldest one is
+ * waited for and presented, which bounds the latency to that many frames
+ * and keeps the render thread off the slot being presented: frame N is
+ * on screen while frame N + 1 is drawn.
+*/
+
+void submitFrame(void)
+{
+	int slot = framesSubmitted % config.pipelineDepth;
+
+	poses[slot].x = player.x;
+	poses[slot].y = player.y;
+	poses[slot].angle = player.rotationAngle;
+	framesSubmitted++;
+	if (!renderThread)
+	{
+		renderSlot(slot);
+		benchStart(BENCH_PRESENT);
+		renderColorBuffer(slot);
+		benchStop(BENCH_PRESENT);
+		framesPresented++;
+		return;
+	}
+	SDL_SemPost(framesQueued);
+	if (framesSubmitted - framesPresented == config.pipelineDepth)
+		presentOldest();
+}
+
+/**
+ * destroyPipeline - present the frames in flight and stop the render thread
+ *
+*/
+
+void destroyPipeline(void)
+{
+	if (!renderThread)
+		return;
+	while (framesPresented < framesSubmitted)
+		presentOldest();
+	SDL_AtomicSet(&stopping, 1);
+	SDL_SemPost(framesQueued);
+	SDL_WaitThread(renderThread, NULL);
+	renderThread = NULL;
+	destroySemaphores();
+}
@@ -39,8 +39,8 @@ void movePlayer(float DeltaTime)
 void renderPlayer(void)
 {
     drawRect(
-        player.x * MINIMAP_SCALE_FACTOR,  // X coordinate scaled for minimap
-        player.y * MINIMAP_SCALE_FACTOR,  // Y coordinate scaled for minimap
+        view.x * MINIMAP_SCALE_FACTOR,    // X coordinate scaled for minimap
+        view.y * MINIMAP_SCALE_FACTOR,    // Y coordinate scaled for minimap
         player.width * MINIMAP_SCALE_FACTOR,  // Width scaled for minimap
         player.height * MINIMAP_SCALE_FACTOR, // Height scaled for minimap
         0xFFFFFFFF  // Color (white)
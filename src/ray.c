@@ -1,101 +1,207 @@
 #include "../headers/header.h"
 
 ray_t rays[NUM_RAYS];
+ray_t rayHits[NUM_RAYS][MAX_RAY_HITS];
+static SDL_atomic_t raysCast;
 
-static bool foundHorzWallHit, foundVertWallHit;
-static float horzWallHitX, horzWallHitY, vertWallHitX, vertWallHitY;
-static int horzWallContent, vertWallContent;
+/**
+ * initRayWalkAt - prepare the DDA state of a ray leaving any point
+ * @walk: walk state to fill
+ * @originX: x coordinate the ray starts from
+ * @originY: y coordinate the ray starts from
+ * @rayAngle: ray angle, normalized here to [0, 2 * PI)
+ */
 
+void initRayWalkAt(rayWalk_t *walk, float originX, float originY, float rayAngle)
+{
+	rayAngle = remainder(rayAngle, TWO_PI);
+	if (rayAngle < 0)
+		rayAngle = TWO_PI + rayAngle;
+
+	walk->rayAngle = rayAngle;
+	walk->dirX = cos(rayAngle);
+	walk->dirY = sin(rayAngle);
+	walk->mapX = (int)(originX / TILE_SIZE);
+	walk->mapY = (int)(originY / TILE_SIZE);
+
+	walk->deltaDistX = walk->dirX != 0 ? fabsf(TILE_SIZE / walk->dirX) : FLT_MAX;
+	walk->deltaDistY = walk->dirY != 0 ? fabsf(TILE_SIZE / walk->dirY) : FLT_MAX;
+	walk->stepX = walk->dirX < 0 ? -1 : 1;
+	walk->stepY = walk->dirY < 0 ? -1 : 1;
+	if (walk->dirX == 0)
+		walk->sideDistX = FLT_MAX;
+	else if (walk->dirX < 0)
+		walk->sideDistX = (originX - walk->mapX * TILE_SIZE) / -walk->dirX;
+	else
+		walk->sideDistX = ((walk->mapX + 1) * TILE_SIZE - originX) / walk->dirX;
+	if (walk->dirY == 0)
+		walk->sideDistY = FLT_MAX;
+	else if (walk->dirY < 0)
+		walk->sideDistY = (originY - walk->mapY * TILE_SIZE) / -walk->dirY;
+	else
+		walk->sideDistY = ((walk->mapY + 1) * TILE_SIZE - originY) / walk->dirY;
+	walk->firstSideDistX = walk->sideDistX;
+	walk->firstSideDistY = walk->sideDistY;
+	walk->startX = walk->mapX;
+	walk->startY = walk->mapY;
+
+	walk->distance = 0;
+	walk->vertical = false;
+	walk->content = 0;
+}
 
 /**
- * horzIntersection - Finds horizontal intersection with the wall
- * @rayAngle: current ray angle
- *
+ * initRayWalk - prepare the DDA state of a ray leaving the player
+ * @walk: walk state to fill
+ * @rayAngle: ray angle, normalized here to [0, 2 * PI)
  */
 
-void horzIntersection(float rayAngle)
+void initRayWalk(rayWalk_t *walk, float rayAngle)
 {
-	float nextHorzTouchX, nextHorzTouchY, xintercept, yintercept, xstep, ystep;
+	initRayWalkAt(walk, view.x, view.y, rayAngle);
+}
 
-	foundHorzWallHit = false;
-	horzWallHitX = horzWallHitY = horzWallContent = 0;
+/**
+ * fillRayHit - describe the cell a walk stopped on
+ * @ray: hit record to fill
+ * @col: screen column of the ray
+ * @walk: walk stopped on the hit cell
+ */
 
-	yintercept = floor(player.y / TILE_SIZE) * TILE_SIZE;
-	yintercept += isRayFacingDown(rayAngle) ? TILE_SIZE : 0;
+static void fillRayHit(ray_t *ray, int col, const rayWalk_t *walk)
+{
+	float distance = walk->distance;
+
+	ray->rayAngle = walk->rayAngle;
+	ray->distance = distance;
+	ray->perpDistance = distance * camera.columnCos[col];
+	ray->wasHitVertical = walk->vertical;
+	ray->wallHitContent = walk->content;
+	ray->mapX = walk->mapX;
+	ray->mapY = walk->mapY;
+	if (walk->vertical)
+	{
+		ray->wallHitX = (walk->stepX > 0 ? walk->mapX : walk->mapX + 1) * TILE_SIZE;
+		ray->wallHitY = view.y + distance * walk->dirY;
+		ray->textureOffsetX = (int)ray->wallHitY % TILE_SIZE;
+	}
+	else
+	{
+		ray->wallHitX = view.x + distance * walk->dirX;
+		ray->wallHitY = (walk->stepY > 0 ? walk->mapY : walk->mapY + 1) * TILE_SIZE;
+		ray->textureOffsetX = (int)ray->wallHitX % TILE_SIZE;
+	}
+}
 
-	xintercept = player.x + (yintercept - player.y) / tan(rayAngle);
+/**
+ * storeRayHit - fill the ray of a column from a finished walk
+ * @col: screen column of the ray
+ * @walk: walk stopped on the hit cell
+ *
+ * See-through cells are recorded in rayHits and the walk carries on
+ * behind them until an opaque wall.
+ */
 
-	ystep = TILE_SIZE;
-	ystep *= isRayFacingUp(rayAngle) ? -1 : 1;
-	xstep = TILE_SIZE / tan(rayAngle);
-	xstep *= (isRayFacingLeft(rayAngle) && xstep > 0) ? -1 : 1;
-	xstep *= (isRayFacingRight(rayAngle) && xstep < 0) ? -1 : 1;
-	nextHorzTouchX = xintercept;
-	nextHorzTouchY = yintercept;
+void storeRayHit(int col, rayWalk_t *walk)
+{
+	int numHits = 0;
 
-	while (isInsideMap(nextHorzTouchX, nextHorzTouchY))
+	/* keep going through see-through cells, remembering the first ones */
+	while (walk->content != 0 && isSeeThrough(walk->content))
 	{
-		float xToCheck = nextHorzTouchX;
-		float yToCheck = nextHorzTouchY + (isRayFacingUp(rayAngle) ? -1 : 0);
-
-		if (DetectCollision(xToCheck, yToCheck))
-		{
-			horzWallHitX = nextHorzTouchX;
-			horzWallHitY = nextHorzTouchY;
-			horzWallContent = getMapValue((int)floor(yToCheck / TILE_SIZE),
-									   (int)floor(xToCheck / TILE_SIZE));
-			foundHorzWallHit = true;
-			break;
-		}
-		nextHorzTouchX += xstep;
-		nextHorzTouchY += ystep;
+		if (numHits < MAX_RAY_HITS)
+			fillRayHit(&rayHits[col][numHits++], col, walk);
+		walk->content = 0;
+		walkRay(walk);
 	}
+
+	fillRayHit(&rays[col], col, walk);
+	rays[col].numHits = numHits;
 }
 
 /**
- * vertIntersection - Finds vertical intersection with the wall
- * @rayAngle: current ray angle
+ * seekRayWalk - move a walk to a cell of its ray
+ * @walk: initialized walk
+ * @mapX: column of the cell
+ * @mapY: row of the cell
+ *
+ * The side distances are derived from the number of grid lines crossed
+ * since the start rather than accumulated, so they only depend on the
+ * cell and not on the path, jumps included, that led there.
+ */
+
+void seekRayWalk(rayWalk_t *walk, int mapX, int mapY)
+{
+	walk->mapX = mapX;
+	walk->mapY = mapY;
+	walk->sideDistX = walk->firstSideDistX
+		+ (float)((mapX - walk->startX) * walk->stepX) * walk->deltaDistX;
+	walk->sideDistY = walk->firstSideDistY
+		+ (float)((mapY - walk->startY) * walk->stepY) * walk->deltaDistY;
+}
+
+/**
+ * skipEmptyCells - jump a walk across the empty box around its cell
+ * @walk: walk currently in an empty cell
+ * @radius: empty radius of that cell, at least 2
+ *
+ * Every cell within radius - 1 of the current one is empty, so all grid
+ * crossings before the ray leaves that box are taken at once. The next
+ * regular DDA step is then the one that exits the box.
+ */
+
+static void skipEmptyCells(rayWalk_t *walk, int radius)
+{
+	float exitX = walk->sideDistX + (radius - 1) * walk->deltaDistX;
+	float exitY = walk->sideDistY + (radius - 1) * walk->deltaDistY;
+	float exitDist = exitX < exitY ? exitX : exitY;
+	int stepsX = 0, stepsY = 0;
+
+	if (walk->sideDistX < exitDist)
+		stepsX = (int)ceilf((exitDist - walk->sideDistX) / walk->deltaDistX);
+	if (walk->sideDistY < exitDist)
+		stepsY = (int)ceilf((exitDist - walk->sideDistY) / walk->deltaDistY);
+	stepsX = stepsX > radius - 1 ? radius - 1 : stepsX;
+	stepsY = stepsY > radius - 1 ? radius - 1 : stepsY;
+
+	seekRayWalk(walk, walk->mapX + stepsX * walk->stepX,
+				walk->mapY + stepsY * walk->stepY);
+}
+
+/**
+ * walkRay - run a walk until it enters a wall or leaves the map
+ * @walk: initialized walk, left on the hit cell
  *
+ * Walks the grid once with a DDA, stepping whole cells along whichever
+ * axis has the nearest boundary, until a non-empty cell is entered.
+ * Open areas are crossed in one jump using the map's empty radius.
  */
 
-void vertIntersection(float rayAngle)
+void walkRay(rayWalk_t *walk)
 {
-	float nextVertTouchX, nextVertTouchY;
-	float xintercept, yintercept, xstep, ystep;
-
-	foundVertWallHit = false;
-	vertWallHitX = 0;
-	vertWallHitY = 0;
-	vertWallContent = 0;
-
-	xintercept = floor(player.x / TILE_SIZE) * TILE_SIZE;
-	xintercept += isRayFacingRight(rayAngle) ? TILE_SIZE : 0;
-	yintercept = player.y + (xintercept - player.x) * tan(rayAngle);
-
-	xstep = TILE_SIZE;
-	xstep *= isRayFacingLeft(rayAngle) ? -1 : 1;
-	ystep = TILE_SIZE * tan(rayAngle);
-	ystep *= (isRayFacingUp(rayAngle) && ystep > 0) ? -1 : 1;
-	ystep *= (isRayFacingDown(rayAngle) && ystep < 0) ? -1 : 1;
-	nextVertTouchX = xintercept;
-	nextVertTouchY = yintercept;
-
-	while (isInsideMap(nextVertTouchX, nextVertTouchY))
+	while (walk->content == 0)
 	{
-		float xToCheck = nextVertTouchX + (isRayFacingLeft(rayAngle) ? -1 : 0);
-		float yToCheck = nextVertTouchY;
+		int radius = getEmptyRadius(walk->mapY, walk->mapX);
 
-		if (DetectCollision(xToCheck, yToCheck))
+		if (radius > 1)
+			skipEmptyCells(walk, radius);
+		if (walk->sideDistX < walk->sideDistY)
 		{
-			vertWallHitX = nextVertTouchX;
-			vertWallHitY = nextVertTouchY;
-			vertWallContent = getMapValue((int)floor(yToCheck / TILE_SIZE),
-									   (int)floor(xToCheck / TILE_SIZE));
-			foundVertWallHit = true;
-			break;
+			walk->distance = walk->sideDistX;
+			seekRayWalk(walk, walk->mapX + walk->stepX, walk->mapY);
+			walk->vertical = true;
 		}
-		nextVertTouchX += xstep;
-		nextVertTouchY += ystep;
+		else
+		{
+			walk->distance = walk->sideDistY;
+			seekRayWalk(walk, walk->mapX, walk->mapY + walk->stepY);
+			walk->vertical = false;
+		}
+		if (walk->mapX < 0 || walk->mapX >= MAP_NUM_COLS ||
+			walk->mapY < 0 || walk->mapY >= MAP_NUM_ROWS)
+			break;
+		if (isCellSolid(walk->mapY, walk->mapX))
+			walk->content = getMapValue(walk->mapY, walk->mapX);
 	}
 }
 
@@ -103,62 +209,95 @@ void vertIntersection(float rayAngle)
  * castRay - casting of each ray
  * @rayAngle: current ray angle
  * @stripId: ray strip identifier
+ *
+ * Takes the hit from the baked ray table when it has one for the
+ * player's position and the angle, and walks the grid otherwise.
  */
 
 void castRay(float rayAngle, int stripId)
 {
-	float horzHitDistance, vertHitDistance;
+	rayWalk_t walk;
 
-	rayAngle = remainder(rayAngle, TWO_PI);
-	if (rayAngle < 0)
-		rayAngle = TWO_PI + rayAngle;
+	initRayWalk(&walk, rayAngle);
+	if (!lookupRayTable(&walk))
+		walkRay(&walk);
+	storeRayHit(stripId, &walk);
+}
+
+/**
+ * getColumnAngle - angle of the ray going through a screen column
+ * @col: screen column
+ * Return: the ray angle, not normalized
+ */
+
+float getColumnAngle(int col)
+{
+	return (view.angle + camera.columnAngle[col]);
+}
+
+/**
+ * useAdaptiveCast - check whether columns are cast by edge finding
+ * Return: true if MAZE_ADAPTIVE is set and the map allows it
+ */
 
-	horzIntersection(rayAngle);
+static bool useAdaptiveCast(void)
+{
+	return (config.adaptiveStep > 1 && !config.fixedPoint && !mapHasSeeThrough());
+}
 
-	vertIntersection(rayAngle);
+/**
+ * castRayRange - cast the rays of a range of columns and fill their
+ * G-buffer entries
+ * @start: first column
+ * @end: one past the last column
+ * @data: unused
+ */
 
-	horzHitDistance = foundHorzWallHit
-		? distanceBetweenPoints(player.x, player.y, horzWallHitX, horzWallHitY)
-		: FLT_MAX;
-	vertHitDistance = foundVertWallHit
-		? distanceBetweenPoints(player.x, player.y, vertWallHitX, vertWallHitY)
-		: FLT_MAX;
+static void castRayRange(int start, int end, void *data)
+{
+	int col, cast = end - start;
 
-	if (vertHitDistance < horzHitDistance)
+	(void)data;
+	if (config.fixedPoint)
 	{
-		rays[stripId].distance = vertHitDistance;
-		rays[stripId].wallHitX = vertWallHitX;
-		rays[stripId].wallHitY = vertWallHitY;
-		rays[stripId].wallHitContent = vertWallContent;
-		rays[stripId].wasHitVertical = true;
-		rays[stripId].rayAngle = rayAngle;
+		for (col = start; col < end; col++)
+			castRayFixed(col);
 	}
+	else if (useAdaptiveCast())
+		cast = castRaysAdaptive(start, end);
 	else
 	{
-		rays[stripId].distance = horzHitDistance;
-		rays[stripId].wallHitX = horzWallHitX;
-		rays[stripId].wallHitY = horzWallHitY;
-		rays[stripId].wallHitContent = horzWallContent;
-		rays[stripId].wasHitVertical = false;
-		rays[stripId].rayAngle = rayAngle;
+		col = config.simdRays && !rayTableReady()
+			? castRayPackets(start, end) : start;
+		for (; col < end; col++)
+			castRay(getColumnAngle(col), col);
 	}
-
+	SDL_AtomicAdd(&raysCast, cast);
+	writeGBuffer(start, end);
 }
 
 /**
  * castAllRays - cast of all rays
  *
+ * Columns are independent, so they are spread across the worker pool.
  */
 
 void castAllRays(void)
 {
-	int col;
-
-	for (col = 0; col < NUM_RAYS; col++)
+	benchStart(BENCH_CAST);
+	if (config.fixedPoint)
+		beginFixedFrame();
+	runWorkers(castRayRange, NUM_RAYS,
+			   useAdaptiveCast() ? ADAPTIVE_CHUNK_SIZE : RAY_CHUNK_SIZE, NULL);
+	benchStop(BENCH_CAST);
+	benchCount(BENCH_RAYS_CAST, SDL_AtomicSet(&raysCast, 0));
+
+	if (config.benchFrames > 0)
 	{
-		float rayAngle = player.rotationAngle +
-							atan((col - NUM_RAYS / 2) / PROJ_PLANE);
-		castRay(rayAngle, col);
+		int col;
+
+		for (col = 0; col < NUM_RAYS; col++)
+			benchCount(BENCH_RAY_HITS, rays[col].numHits + 1);
 	}
 }
 
@@ -174,11 +313,11 @@ void renderRays(void)
 	for (i = 0; i < NUM_RAYS; i += 50)
 	{
 		drawLine(
-			player.x * MINIMAP_SCALE_FACTOR,
-			player.y * MINIMAP_SCALE_FACTOR,
+			view.x * MINIMAP_SCALE_FACTOR,
+			view.y * MINIMAP_SCALE_FACTOR,
 			rays[i].wallHitX * MINIMAP_SCALE_FACTOR,
 			rays[i].wallHitY * MINIMAP_SCALE_FACTOR,
-			0xFF0000FF
+			packColor(255, 0, 0, 255)
 		);
 	}
 }
@@ -0,0 +1,101 @@
+#include "../headers/header.h"
+
+/**
+ * sameWallFace - check whether two rays hit the same face of a cell
+ * @a: first ray
+ * @b: second ray
+ * Return: true if both rays ended on the same cell and the same side
+*/
+
+static bool sameWallFace(const ray_t *a, const ray_t *b)
+{
+	return (a->wallHitContent != 0 && a->mapX == b->mapX &&
+			a->mapY == b->mapY && a->wasHitVertical == b->wasHitVertical &&
+			a->wallHitContent == b->wallHitContent);
+}
+
+/**
+ * fillFromFace - compute a column's hit on a known wall face
+ * @col: column to fill
+ * @face: ray of a neighbouring column that hit the face
+ *
+ * The distance is the side distance the grid walk has in the cell in
+ * front of the face, so the hit has the same bits as a traced one.
+*/
+
+static void fillFromFace(int col, const ray_t *face)
+{
+	rayWalk_t walk;
+
+	initRayWalk(&walk, getColumnAngle(col));
+	if (face->wasHitVertical)
+	{
+		seekRayWalk(&walk, face->mapX - walk.stepX, face->mapY);
+		walk.distance = walk.sideDistX;
+	}
+	else
+	{
+		seekRayWalk(&walk, face->mapX, face->mapY - walk.stepY);
+		walk.distance = walk.sideDistY;
+	}
+	seekRayWalk(&walk, face->mapX, face->mapY);
+	walk.vertical = face->wasHitVertical;
+	walk.content = face->wallHitContent;
+	storeRayHit(col, &walk);
+}
+
+/**
+ * refineSpan - resolve the columns strictly between two cast columns
+ * @left: cast column on the left
+ * @right: cast column on the right
+ *
+ * Matching hits are filled from their face, otherwise the span is cut
+ * in half and the middle column is cast.
+ * Return: the number of columns cast
+*/
+
+static int refineSpan(int left, int right)
+{
+	int col, mid;
+
+	if (right - left <= 1)
+		return (0);
+	if (sameWallFace(&rays[left], &rays[right]))
+	{
+		for (col = left + 1; col < right; col++)
+			fillFromFace(col, &rays[left]);
+		return (0);
+	}
+	mid = (left + right) / 2;
+	castRay(getColumnAngle(mid), mid);
+	return (1 + refineSpan(left, mid) + refineSpan(mid, right));
+}
+
+/**
+ * castRaysAdaptive - cast a column range by edge finding
+ * @start: first column
+ * @end: one past the last column
+ *
+ * Only every config.adaptiveStep column is traced up front; spans
+ * between them are subdivided until both ends see the same wall face.
+ * A wall narrower than the step standing in front of a single face can
+ * be missed, which on our maps needs it to be over a hundred tiles away.
+ * Both ends of the range are always cast, so ranges are kept wide.
+ * Return: the number of columns cast
+*/
+
+int castRaysAdaptive(int start, int end)
+{
+	int left, right, cast = 1;
+
+	castRay(getColumnAngle(start), start);
+	for (left = start; left < end - 1; left = right)
+	{
+		right = left + config.adaptiveStep;
+		if (right > end - 1)
+			right = end - 1;
+		castRay(getColumnAngle(right), right);
+		cast += 1 + refineSpan(left, right);
+	}
+	return (cast);
+}
@@ -0,0 +1,431 @@
+#include "../headers/header.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define HAVE_X86_PACKETS 1
+#endif
+
+#define MAX_PACKET_WIDTH 8
+
+static int packetWidth;
+static void (*tracePacket)(rayWalk_t *walks);
+
+#ifdef HAVE_X86_PACKETS
+
+/**
+ * tracePacketAVX2 - walk 8 rays through the grid together
+ * @walks: 8 initialized walks, updated with their hits
+ *
+ * Each lane runs the same DDA step as walkRay, including its jump
+ * across empty space, and like seekRayWalk derives its side distances
+ * from the grid lines crossed, so hits are bit-exact with scalar
+ * casting. Lanes that reached a wall or left the map are masked out
+ * until the whole packet is done. Cells and radii are gathered as
+ * 32-bit loads from the byte planes and masked down to their first byte.
+*/
+
+/**
+ * skipEmptyAVX2 - count the grid lines a jump across an empty box crosses
+ * @radius: empty radius of each lane's cell, lanes below 2 do not jump
+ * @sideDist: side distances along the axis
+ * @exitDist: distance at which each lane leaves its box
+ * @deltaDist: distances between grid lines along the axis
+ * Return: the crossings of each lane, as skipEmptyCells counts them
+*/
+
+__attribute__((target("avx2")))
+static inline __m256i skipEmptyAVX2(__m256i radius, __m256 sideDist,
+	__m256 exitDist, __m256 deltaDist)
+{
+	__m256i steps = _mm256_cvttps_epi32(_mm256_ceil_ps(
+		_mm256_div_ps(_mm256_sub_ps(exitDist, sideDist), deltaDist)));
+
+	steps = _mm256_min_epi32(steps, _mm256_sub_epi32(radius, _mm256_set1_epi32(1)));
+	return (_mm256_and_si256(steps, _mm256_and_si256(
+		_mm256_castps_si256(_mm256_cmp_ps(sideDist, exitDist, _CMP_LT_OQ)),
+		_mm256_cmpgt_epi32(radius, _mm256_set1_epi32(1)))));
+}
+
+__attribute__((target("avx2")))
+static void tracePacketAVX2(rayWalk_t *walks)
+{
+	const uint8_t *grid = getMaterialPlane();
+	const uint8_t *radii = getRadiusPlane();
+	float sideX[8], sideY[8], deltaX[8], deltaY[8], dist[8];
+	int mapXs[8], mapYs[8], stepXs[8], stepYs[8], vert[8], cont[8];
+	int crossXs[8], crossYs[8];
+	__m256 sideDistX, sideDistY, firstX, firstY, deltaDistX, deltaDistY, distance;
+	__m256i mapX, mapY, stepX, stepY, crossX, crossY, vertical, content, active;
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i lastCol = _mm256_set1_epi32(MAP_NUM_COLS - 1);
+	const __m256i lastRow = _mm256_set1_epi32(MAP_NUM_ROWS - 1);
+	const __m256i numCols = _mm256_set1_epi32(MAP_NUM_COLS);
+	const __m256i byteMask = _mm256_set1_epi32(0xFF);
+	const __m256i one = _mm256_set1_epi32(1);
+	int i;
+
+	for (i = 0; i < 8; i++)
+	{
+		sideX[i] = walks[i].firstSideDistX;
+		sideY[i] = walks[i].firstSideDistY;
+		deltaX[i] = walks[i].deltaDistX;
+		deltaY[i] = walks[i].deltaDistY;
+		mapXs[i] = walks[i].mapX;
+		mapYs[i] = walks[i].mapY;
+		stepXs[i] = walks[i].stepX;
+		stepYs[i] = walks[i].stepY;
+		crossXs[i] = (walks[i].mapX - walks[i].startX) * walks[i].stepX;
+		crossYs[i] = (walks[i].mapY - walks[i].startY) * walks[i].stepY;
+	}
+	firstX = _mm256_loadu_ps(sideX);
+	firstY = _mm256_loadu_ps(sideY);
+	deltaDistX = _mm256_loadu_ps(deltaX);
+	deltaDistY = _mm256_loadu_ps(deltaY);
+	mapX = _mm256_loadu_si256((const __m256i *)mapXs);
+	mapY = _mm256_loadu_si256((const __m256i *)mapYs);
+	stepX = _mm256_loadu_si256((const __m256i *)stepXs);
+	stepY = _mm256_loadu_si256((const __m256i *)stepYs);
+	crossX = _mm256_loadu_si256((const __m256i *)crossXs);
+	crossY = _mm256_loadu_si256((const __m256i *)crossYs);
+	sideDistX = _mm256_add_ps(firstX,
+		_mm256_mul_ps(_mm256_cvtepi32_ps(crossX), deltaDistX));
+	sideDistY = _mm256_add_ps(firstY,
+		_mm256_mul_ps(_mm256_cvtepi32_ps(crossY), deltaDistY));
+	distance = _mm256_setzero_ps();
+	vertical = zero;
+	content = zero;
+	active = _mm256_set1_epi32(-1);
+
+	while (!_mm256_testz_si256(active, active))
+	{
+		__m256i radius = _mm256_and_si256(byteMask,
+			_mm256_mask_i32gather_epi32(zero, (const int *)radii,
+				_mm256_add_epi32(_mm256_mullo_epi32(mapY, numCols), mapX), active, 1));
+		__m256i xFirst, stepsX, stepsY, outside, inside, cell;
+
+		if (!_mm256_testz_si256(radius, _mm256_cmpgt_epi32(radius, one)))
+		{
+			__m256 reach = _mm256_cvtepi32_ps(_mm256_sub_epi32(radius, one));
+			__m256 exitDist = _mm256_min_ps(
+				_mm256_add_ps(sideDistX, _mm256_mul_ps(reach, deltaDistX)),
+				_mm256_add_ps(sideDistY, _mm256_mul_ps(reach, deltaDistY)));
+
+			stepsX = skipEmptyAVX2(radius, sideDistX, exitDist, deltaDistX);
+			stepsY = skipEmptyAVX2(radius, sideDistY, exitDist, deltaDistY);
+			crossX = _mm256_add_epi32(crossX, stepsX);
+			crossY = _mm256_add_epi32(crossY, stepsY);
+			mapX = _mm256_add_epi32(mapX, _mm256_sign_epi32(stepsX, stepX));
+			mapY = _mm256_add_epi32(mapY, _mm256_sign_epi32(stepsY, stepY));
+			sideDistX = _mm256_add_ps(firstX,
+				_mm256_mul_ps(_mm256_cvtepi32_ps(crossX), deltaDistX));
+			sideDistY = _mm256_add_ps(firstY,
+				_mm256_mul_ps(_mm256_cvtepi32_ps(crossY), deltaDistY));
+		}
+
+		xFirst = _mm256_castps_si256(_mm256_cmp_ps(sideDistX, sideDistY, _CMP_LT_OQ));
+		stepsX = _mm256_and_si256(xFirst, active);
+		stepsY = _mm256_andnot_si256(xFirst, active);
+
+		distance = _mm256_blendv_ps(distance, sideDistX, _mm256_castsi256_ps(stepsX));
+		distance = _mm256_blendv_ps(distance, sideDistY, _mm256_castsi256_ps(stepsY));
+		crossX = _mm256_sub_epi32(crossX, stepsX);
+		crossY = _mm256_sub_epi32(crossY, stepsY);
+		sideDistX = _mm256_add_ps(firstX,
+			_mm256_mul_ps(_mm256_cvtepi32_ps(crossX), deltaDistX));
+		sideDistY = _mm256_add_ps(firstY,
+			_mm256_mul_ps(_mm256_cvtepi32_ps(crossY), deltaDistY));
+		mapX = _mm256_add_epi32(mapX, _mm256_and_si256(stepX, stepsX));
+		mapY = _mm256_add_epi32(mapY, _mm256_and_si256(stepY, stepsY));
+		vertical = _mm256_blendv_epi8(vertical, stepsX, active);
+
+		outside = _mm256_or_si256(
+			_mm256_or_si256(_mm256_cmpgt_epi32(zero, mapX),
+							_mm256_cmpgt_epi32(mapX, lastCol)),
+			_mm256_or_si256(_mm256_cmpgt_epi32(zero, mapY),
+							_mm256_cmpgt_epi32(mapY, lastRow)));
+		inside = _mm256_andnot_si256(outside, active);
+		cell = _mm256_mask_i32gather_epi32(zero, (const int *)grid,
+			_mm256_add_epi32(_mm256_mullo_epi32(mapY, numCols), mapX), inside, 1);
+		cell = _mm256_and_si256(cell, byteMask);
+		content = _mm256_blendv_epi8(content, cell, inside);
+		active = _mm256_and_si256(inside, _mm256_cmpeq_epi32(cell, zero));
+	}
+
+	_mm256_storeu_ps(dist, distance);
+	_mm256_storeu_ps(sideX, sideDistX);
+	_mm256_storeu_ps(sideY, sideDistY);
+	_mm256_storeu_si256((__m256i *)vert, vertical);
+	_mm256_storeu_si256((__m256i *)cont, content);
+	_mm256_storeu_si256((__m256i *)mapXs, mapX);
+	_mm256_storeu_si256((__m256i *)mapYs, mapY);
+	for (i = 0; i < 8; i++)
+	{
+		walks[i].sideDistX = sideX[i];
+		walks[i].sideDistY = sideY[i];
+		walks[i].distance = dist[i];
+		walks[i].vertical = vert[i] != 0;
+		walks[i].content = cont[i];
+		walks[i].mapX = mapXs[i];
+		walks[i].mapY = mapYs[i];
+	}
+}
+
+/**
+ * selectPS - pick b where mask is set and a elsewhere
+ * @mask: lane mask
+ * @a: value for clear lanes
+ * @b: value for set lanes
+ * Return: the blended vector
+*/
+
+__attribute__((target("sse2")))
+static inline __m128 selectPS(__m128i mask, __m128 a, __m128 b)
+{
+	__m128 m = _mm_castsi128_ps(mask);
+
+	return (_mm_or_ps(_mm_and_ps(m, b), _mm_andnot_ps(m, a)));
+}
+
+/**
+ * selectEpi32 - pick b where mask is set and a elsewhere
+ * @mask: lane mask
+ * @a: value for clear lanes
+ * @b: value for set lanes
+ * Return: the blended vector
+*/
+
+__attribute__((target("sse2")))
+static inline __m128i selectEpi32(__m128i mask, __m128i a, __m128i b)
+{
+	return (_mm_or_si128(_mm_and_si128(mask, b), _mm_andnot_si128(mask, a)));
+}
+
+/**
+ * skipEmptySSE2 - count the grid lines a jump across an empty box crosses
+ * @radius: empty radius of each lane's cell, lanes below 2 do not jump
+ * @sideDist: side distances along the axis
+ * @exitDist: distance at which each lane leaves its box
+ * @deltaDist: distances between grid lines along the axis
+ *
+ * SSE2 has no ceil, so the truncated quotient is bumped when it is below
+ * the quotient, which is the same for the positive lanes that are kept.
+ * Return: the crossings of each lane, as skipEmptyCells counts them
+*/
+
+__attribute__((target("sse2")))
+static inline __m128i skipEmptySSE2(__m128i radius, __m128 sideDist,
+	__m128 exitDist, __m128 deltaDist)
+{
+	const __m128i one = _mm_set1_epi32(1);
+	__m128 quotient = _mm_div_ps(_mm_sub_ps(exitDist, sideDist), deltaDist);
+	__m128i steps = _mm_cvttps_epi32(quotient);
+	__m128i reach = _mm_sub_epi32(radius, one);
+
+	steps = _mm_sub_epi32(steps, _mm_castps_si128(
+		_mm_cmplt_ps(_mm_cvtepi32_ps(steps), quotient)));
+	steps = selectEpi32(_mm_cmpgt_epi32(steps, reach), steps, reach);
+	return (_mm_and_si128(steps, _mm_and_si128(
+		_mm_castps_si128(_mm_cmplt_ps(sideDist, exitDist)),
+		_mm_cmpgt_epi32(radius, one))));
+}
+
+/**
+ * signEpi32 - negate the lanes of a whose b is negative
+ * @a: values
+ * @b: signs, -1 or 1
+ * Return: a * b
+*/
+
+__attribute__((target("sse2")))
+static inline __m128i signEpi32(__m128i a, __m128i b)
+{
+	__m128i negative = _mm_srai_epi32(b, 31);
+
+	return (_mm_sub_epi32(_mm_xor_si128(a, negative), negative));
+}
+
+/**
+ * tracePacketSSE2 - walk 4 rays through the grid together
+ * @walks: 4 initialized walks, updated with their hits
+ *
+ * Side distances and empty space jumps are done as in tracePacketAVX2.
+ * SSE2 has no gather, so the cell and radius lookups of the live lanes
+ * are scalar.
+*/
+
+__attribute__((target("sse2")))
+static void tracePacketSSE2(rayWalk_t *walks)
+{
+	const uint8_t *grid = getMaterialPlane();
+	const uint8_t *radii = getRadiusPlane();
+	float sideX[4], sideY[4], deltaX[4], deltaY[4], dist[4];
+	int mapXs[4], mapYs[4], stepXs[4], stepYs[4], vert[4], cont[4];
+	int crossXs[4], crossYs[4], inside[4], cells[4], reach[4];
+	__m128 sideDistX, sideDistY, firstX, firstY, deltaDistX, deltaDistY, distance;
+	__m128i mapX, mapY, stepX, stepY, crossX, crossY, vertical, content, active;
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i lastCol = _mm_set1_epi32(MAP_NUM_COLS - 1);
+	const __m128i lastRow = _mm_set1_epi32(MAP_NUM_ROWS - 1);
+	int i;
+
+	for (i = 0; i < 4; i++)
+	{
+		sideX[i] = walks[i].firstSideDistX;
+		sideY[i] = walks[i].firstSideDistY;
+		deltaX[i] = walks[i].deltaDistX;
+		deltaY[i] = walks[i].deltaDistY;
+		mapXs[i] = walks[i].mapX;
+		mapYs[i] = walks[i].mapY;
+		stepXs[i] = walks[i].stepX;
+		stepYs[i] = walks[i].stepY;
+		crossXs[i] = (walks[i].mapX - walks[i].startX) * walks[i].stepX;
+		crossYs[i] = (walks[i].mapY - walks[i].startY) * walks[i].stepY;
+		inside[i] = -1;
+	}
+	firstX = _mm_loadu_ps(sideX);
+	firstY = _mm_loadu_ps(sideY);
+	deltaDistX = _mm_loadu_ps(deltaX);
+	deltaDistY = _mm_loadu_ps(deltaY);
+	mapX = _mm_loadu_si128((const __m128i *)mapXs);
+	mapY = _mm_loadu_si128((const __m128i *)mapYs);
+	stepX = _mm_loadu_si128((const __m128i *)stepXs);
+	stepY = _mm_loadu_si128((const __m128i *)stepYs);
+	crossX = _mm_loadu_si128((const __m128i *)crossXs);
+	crossY = _mm_loadu_si128((const __m128i *)crossYs);
+	sideDistX = _mm_add_ps(firstX, _mm_mul_ps(_mm_cvtepi32_ps(crossX), deltaDistX));
+	sideDistY = _mm_add_ps(firstY, _mm_mul_ps(_mm_cvtepi32_ps(crossY), deltaDistY));
+	distance = _mm_setzero_ps();
+	vertical = zero;
+	content = zero;
+	active = _mm_set1_epi32(-1);
+
+	while (_mm_movemask_epi8(active) != 0)
+	{
+		__m128i xFirst, stepsX, stepsY, outside, live, cell, radius;
+		bool jump = false;
+
+		/* mapXs, mapYs and inside still describe the current cells */
+		for (i = 0; i < 4; i++)
+		{
+			reach[i] = inside[i] ? radii[mapYs[i] * MAP_NUM_COLS + mapXs[i]] : 0;
+			jump |= reach[i] > 1;
+		}
+		if (jump)
+		{
+			__m128 exitDist;
+
+			radius = _mm_loadu_si128((const __m128i *)reach);
+			exitDist = _mm_cvtepi32_ps(_mm_sub_epi32(radius, _mm_set1_epi32(1)));
+			exitDist = _mm_min_ps(
+				_mm_add_ps(sideDistX, _mm_mul_ps(exitDist, deltaDistX)),
+				_mm_add_ps(sideDistY, _mm_mul_ps(exitDist, deltaDistY)));
+			stepsX = skipEmptySSE2(radius, sideDistX, exitDist, deltaDistX);
+			stepsY = skipEmptySSE2(radius, sideDistY, exitDist, deltaDistY);
+			crossX = _mm_add_epi32(crossX, stepsX);
+			crossY = _mm_add_epi32(crossY, stepsY);
+			mapX = _mm_add_epi32(mapX, signEpi32(stepsX, stepX));
+			mapY = _mm_add_epi32(mapY, signEpi32(stepsY, stepY));
+			sideDistX = _mm_add_ps(firstX, _mm_mul_ps(_mm_cvtepi32_ps(crossX), deltaDistX));
+			sideDistY = _mm_add_ps(firstY, _mm_mul_ps(_mm_cvtepi32_ps(crossY), deltaDistY));
+		}
+
+		xFirst = _mm_castps_si128(_mm_cmplt_ps(sideDistX, sideDistY));
+		stepsX = _mm_and_si128(xFirst, active);
+		stepsY = _mm_andnot_si128(xFirst, active);
+
+		distance = selectPS(stepsX, distance, sideDistX);
+		distance = selectPS(stepsY, distance, sideDistY);
+		crossX = _mm_sub_epi32(crossX, stepsX);
+		crossY = _mm_sub_epi32(crossY, stepsY);
+		sideDistX = _mm_add_ps(firstX, _mm_mul_ps(_mm_cvtepi32_ps(crossX), deltaDistX));
+		sideDistY = _mm_add_ps(firstY, _mm_mul_ps(_mm_cvtepi32_ps(crossY), deltaDistY));
+		mapX = _mm_add_epi32(mapX, _mm_and_si128(stepX, stepsX));
+		mapY = _mm_add_epi32(mapY, _mm_and_si128(stepY, stepsY));
+		vertical = selectEpi32(active, vertical, stepsX);
+
+		outside = _mm_or_si128(
+			_mm_or_si128(_mm_cmpgt_epi32(zero, mapX), _mm_cmpgt_epi32(mapX, lastCol)),
+			_mm_or_si128(_mm_cmpgt_epi32(zero, mapY), _mm_cmpgt_epi32(mapY, lastRow)));
+		live = _mm_andnot_si128(outside, active);
+
+		_mm_storeu_si128((__m128i *)inside, live);
+		_mm_storeu_si128((__m128i *)mapXs, mapX);
+		_mm_storeu_si128((__m128i *)mapYs, mapY);
+		for (i = 0; i < 4; i++)
+			cells[i] = inside[i] ? grid[mapYs[i] * MAP_NUM_COLS + mapXs[i]] : 0;
+		cell = _mm_loadu_si128((const __m128i *)cells);
+
+		content = selectEpi32(live, content, cell);
+		active = _mm_and_si128(live, _mm_cmpeq_epi32(cell, zero));
+	}
+
+	_mm_storeu_ps(dist, distance);
+	_mm_storeu_ps(sideX, sideDistX);
+	_mm_storeu_ps(sideY, sideDistY);
+	_mm_storeu_si128((__m128i *)vert, vertical);
+	_mm_storeu_si128((__m128i *)cont, content);
+	_mm_storeu_si128((__m128i *)mapXs, mapX);
+	_mm_storeu_si128((__m128i *)mapYs, mapY);
+	for (i = 0; i < 4; i++)
+	{
+		walks[i].sideDistX = sideX[i];
+		walks[i].sideDistY = sideY[i];
+		walks[i].distance = dist[i];
+		walks[i].vertical = vert[i] != 0;
+		walks[i].content = cont[i];
+		walks[i].mapX = mapXs[i];
+		walks[i].mapY = mapYs[i];
+	}
+}
+
+#endif /* HAVE_X86_PACKETS */
+
+/**
+ * initRayPackets - pick the widest packet tracer the CPU supports
+ *
+ * Falls back to the scalar castRay when no SIMD tracer is usable.
+*/
+
+void initRayPackets(void)
+{
+	packetWidth = 0;
+	tracePacket = NULL;
+#ifdef HAVE_X86_PACKETS
+	if (SDL_HasAVX2())
+	{
+		packetWidth = 8;
+		tracePacket = tracePacketAVX2;
+	}
+	else if (SDL_HasSSE2())
+	{
+		packetWidth = 4;
+		tracePacket = tracePacketSSE2;
+	}
+#endif
+}
+
+/**
+ * castRayPackets - cast as many whole packets as fit in a column range
+ * @start: first column
+ * @end: one past the last column
+ * Return: the first column that was not cast
+*/
+
+int castRayPackets(int start, int end)
+{
+	rayWalk_t walks[MAX_PACKET_WIDTH];
+	int col, i;
+
+	if (tracePacket == NULL)
+		return (start);
+
+	for (col = start; col + packetWidth <= end; col += packetWidth)
+	{
+		for (i = 0; i < packetWidth; i++)
+			initRayWalk(&walks[i], getColumnAngle(col + i));
+		tracePacket(walks);
+		for (i = 0; i < packetWidth; i++)
+			storeRayHit(col + i, &walks[i]);
+	}
+	return (col);
+}
@@ -0,0 +1,369 @@
+#include "../headers/header.h"
+
+#define ENTRY_VALID 0x80000000u     // The bucket has a single known hit face
+#define ENTRY_VERTICAL 0x40000000u  // The face is on a vertical grid line
+#define ENTRY_CELL 0x3FFFFFFFu      // Row-major index of the hit cell
+#define MAX_ANGLE_SHIFT 12          // At most 4096 angle buckets
+#define MIN_ANGLE_SHIFT 6           // At least 64 angle buckets
+#define MAX_SUBCELL_SHIFT 2         // At most 4x4 positions per cell
+#define MIN_SUBCELL_SHIFT 1         // At least 2x2 positions per cell
+#define SAMPLE_INSET 0.01f          // Keeps samples inside their bucket
+#define TABLE_CHUNK_SIZE 1024       // Entries built per worker chunk
+
+static uint32_t *rayTable;
+static int cellSlot[MAP_NUM_ROWS][MAP_NUM_COLS];
+static int slotCell[MAP_NUM_ROWS * MAP_NUM_COLS];
+static int subShift, angleShift;
+
+/**
+ * sampleHit - walk one sample ray and summarize where it stops
+ * @x: ray origin x
+ * @y: ray origin y
+ * @angle: ray angle
+ * Return: the table entry describing the hit, 0 if nothing was hit
+*/
+
+static uint32_t sampleHit(float x, float y, float angle)
+{
+	rayWalk_t walk;
+
+	initRayWalkAt(&walk, x, y, angle);
+	walkRay(&walk);
+	if (walk.content == 0)
+		return (0);
+	return (ENTRY_VALID | (walk.vertical ? ENTRY_VERTICAL : 0) |
+			(uint32_t)(walk.mapY * MAP_NUM_COLS + walk.mapX));
+}
+
+/**
+ * hullRowSpan - vertical extent of a convex polygon inside a strip
+ * @hx: x of the polygon vertices, in order
+ * @hy: y of the polygon vertices, in order
+ * @n: number of vertices
+ * @xa: left of the strip
+ * @xb: right of the strip
+ * @span: set to the lowest and highest y of the polygon in the strip
+*/
+
+static void hullRowSpan(const float *hx, const float *hy, int n,
+	float xa, float xb, float span[2])
+{
+	int i;
+
+	span[0] = FLT_MAX;
+	span[1] = -FLT_MAX;
+	for (i = 0; i < n; i++)
+	{
+		float x1 = hx[i], y1 = hy[i];
+		float x2 = hx[(i + 1) % n], y2 = hy[(i + 1) % n];
+		float lo = x1 < x2 ? x1 : x2, hi = x1 < x2 ? x2 : x1;
+		float ends[2];
+		int e;
+
+		lo = lo > xa ? lo : xa;
+		hi = hi < xb ? hi : xb;
+		if (lo > hi)
+			continue;
+		ends[0] = x1 == x2 ? y1 : y1 + (y2 - y1) * (lo - x1) / (x2 - x1);
+		ends[1] = x1 == x2 ? y2 : y1 + (y2 - y1) * (hi - x1) / (x2 - x1);
+		for (e = 0; e < 2; e++)
+		{
+			span[0] = ends[e] < span[0] ? ends[e] : span[0];
+			span[1] = ends[e] > span[1] ? ends[e] : span[1];
+		}
+	}
+}
+
+/**
+ * fanIsClear - check that no wall can hide in front of a stored face
+ * @x0: left of the sub-cell
+ * @y0: top of the sub-cell
+ * @size: side of the sub-cell
+ * @hit: table entry of the face
+ *
+ * A lookup is only used when the ray meets the face line within the
+ * face, so its path lies in the convex hull of the sub-cell and the
+ * face. Agreeing samples do not prove that hull is empty, since a small
+ * wall can sit between them; this checks every cell it overlaps.
+ * Return: true if no cell of the hull but the hit one is solid
+*/
+
+static bool fanIsClear(float x0, float y0, float size, uint32_t hit)
+{
+	int hitX = (hit & ENTRY_CELL) % MAP_NUM_COLS;
+	int hitY = (hit & ENTRY_CELL) / MAP_NUM_COLS;
+	float px[6], py[6], hx[6], hy[6], span[2], minX = FLT_MAX, maxX = -FLT_MAX;
+	int i, j, n = 0, col, row;
+
+	for (i = 0; i < 4; i++)
+	{
+		px[i] = x0 + ((i & 1) ? size : 0);
+		py[i] = y0 + ((i & 2) ? size : 0);
+	}
+	px[4] = px[5] = hitX * TILE_SIZE;
+	py[4] = py[5] = hitY * TILE_SIZE;
+	if (hit & ENTRY_VERTICAL)
+	{
+		px[4] = px[5] = (x0 < px[4] ? hitX : hitX + 1) * TILE_SIZE;
+		py[5] += TILE_SIZE;
+	}
+	else
+	{
+		py[4] = py[5] = (y0 < py[4] ? hitY : hitY + 1) * TILE_SIZE;
+		px[5] += TILE_SIZE;
+	}
+
+	/* gift wrap the six points, starting from the leftmost one */
+	for (i = 1, j = 0; i < 6; i++)
+		if (px[i] < px[j] || (px[i] == px[j] && py[i] < py[j]))
+			j = i;
+	do {
+		int next = (j + 1) % 6;
+
+		hx[n] = px[j];
+		hy[n++] = py[j];
+		for (i = 0; i < 6; i++)
+		{
+			float cross = (px[next] - px[j]) * (py[i] - py[j])
+						- (py[next] - py[j]) * (px[i] - px[j]);
+
+			if (cross < 0 || (cross == 0 && fabsf(px[i] - px[j]) + fabsf(py[i] - py[j])
+							  > fabsf(px[next] - px[j]) + fabsf(py[next] - py[j])))
+				next = i;
+		}
+		j = next;
+	} while ((px[j] != hx[0] || py[j] != hy[0]) && n < 6);
+
+	for (i = 0; i < n; i++)
+	{
+		minX = hx[i] < minX ? hx[i] : minX;
+		maxX = hx[i] > maxX ? hx[i] : maxX;
+	}
+	/* cells the hull only touches along a grid line are not crossed */
+	for (col = (int)floorf(minX / TILE_SIZE); col < (int)ceilf(maxX / TILE_SIZE); col++)
+	{
+		hullRowSpan(hx, hy, n, col * TILE_SIZE > minX ? col * TILE_SIZE : minX,
+					(col + 1) * TILE_SIZE < maxX ? (col + 1) * TILE_SIZE : maxX, span);
+		for (row = (int)floorf(span[0] / TILE_SIZE);
+			 row < (int)ceilf(span[1] / TILE_SIZE); row++)
+			if ((row != hitY || col != hitX) && row >= 0 && row < MAP_NUM_ROWS
+				&& col >= 0 && col < MAP_NUM_COLS && isCellSolid(row, col))
+				return (false);
+	}
+	return (true);
+}
+
+/**
+ * buildTableRange - fill a range of table entries
+ * @start: first entry
+ * @end: one past the last entry
+ * @data: unused
+ *
+ * An entry keeps a face only when rays from all four corners of its
+ * sub-cell, at both edges of its angle bucket, stop on that face, and
+ * nothing else solid lies between the sub-cell and the face.
+*/
+
+static void buildTableRange(int start, int end, void *data)
+{
+	float subSize = (float)TILE_SIZE / (1 << subShift);
+	float bucketSize = TWO_PI / (1 << angleShift);
+	int entry, i;
+
+	(void)data;
+	for (entry = start; entry < end; entry++)
+	{
+		int bucket = entry & ((1 << angleShift) - 1);
+		int sx = (entry >> angleShift) & ((1 << subShift) - 1);
+		int sy = (entry >> (angleShift + subShift)) & ((1 << subShift) - 1);
+		int cell = slotCell[entry >> (angleShift + 2 * subShift)];
+		float x0 = (cell % MAP_NUM_COLS) * TILE_SIZE + sx * subSize;
+		float y0 = (cell / MAP_NUM_COLS) * TILE_SIZE + sy * subSize;
+		float a0 = bucket * bucketSize;
+		uint32_t hit = 0;
+
+		for (i = 0; i < 8; i++)
+		{
+			uint32_t sample = sampleHit(
+				x0 + ((i & 1) ? subSize - SAMPLE_INSET : SAMPLE_INSET),
+				y0 + ((i & 2) ? subSize - SAMPLE_INSET : SAMPLE_INSET),
+				a0 + ((i & 4) ? bucketSize * 0.999f : bucketSize * 0.001f));
+
+			if (i > 0 && sample != hit)
+			{
+				hit = 0;
+				break;
+			}
+			hit = sample;
+		}
+		if (hit != 0 && !fanIsClear(x0, y0, subSize, hit))
+			hit = 0;
+		rayTable[entry] = hit;
+	}
+}
+
+/**
+ * minAngleShift - coarsest angle resolution the map can use
+ *
+ * Buckets are kept narrow enough that one spans less than a tile across
+ * the map diagonal, so a fan cannot open wide enough to pass a whole
+ * wall between its samples.
+ * Return: the smallest angle shift to try
+*/
+
+static int minAngleShift(void)
+{
+	float diagonal = sqrtf((float)(MAP_NUM_ROWS * MAP_NUM_ROWS
+								   + MAP_NUM_COLS * MAP_NUM_COLS));
+	int shift = MIN_ANGLE_SHIFT;
+
+	while (shift < MAX_ANGLE_SHIFT && (1 << shift) < TWO_PI * diagonal)
+		shift++;
+	return (shift);
+}
+
+/**
+ * buildRayTable - bake the first hit face of every table bucket
+ *
+ * The table is indexed by empty cell, sub-cell position and angle
+ * bucket. Its resolution is the finest that fits in
+ * config.rayTableBytes; a budget of 0 disables it. Sub-cell positions
+ * get the budget first: a bucket's fan is at least as wide as its
+ * sub-cell square, and whole-cell squares almost never agree on a face.
+ * Neither goes below its floor; a table that only fits coarser is left
+ * out. See-through cells are stored as the first hit and castRay walks
+ * on from them. Call after prepareMap and initWorkers.
+*/
+
+void buildRayTable(void)
+{
+	size_t budget = config.rayTableBytes, entries = 0;
+	int row, col, numSlots = 0, minShift = minAngleShift();
+	bool fits = false;
+
+	freeRayTable();
+	if (budget == 0)
+		return;
+
+	for (row = 0; row < MAP_NUM_ROWS; row++)
+	{
+		for (col = 0; col < MAP_NUM_COLS; col++)
+		{
+			cellSlot[row][col] = -1;
+			if (isCellSolid(row, col))
+				continue;
+			cellSlot[row][col] = numSlots;
+			slotCell[numSlots++] = row * MAP_NUM_COLS + col;
+		}
+	}
+
+	for (subShift = MAX_SUBCELL_SHIFT; subShift >= MIN_SUBCELL_SHIFT && !fits;
+		 subShift--)
+	{
+		for (angleShift = MAX_ANGLE_SHIFT; angleShift >= minShift; angleShift--)
+		{
+			entries = (size_t)numSlots << (2 * subShift + angleShift);
+			if (entries * sizeof(*rayTable) <= budget && entries <= INT_MAX)
+			{
+				fits = true;
+				break;
+			}
+		}
+	}
+	subShift++;
+	if (!fits)
+	{
+		fprintf(stderr, "Ray table does not fit in %lu bytes.\n",
+				(unsigned long)budget);
+		return;
+	}
+
+	rayTable = malloc(entries * sizeof(*rayTable));
+	if (!rayTable)
+	{
+		fprintf(stderr, "Error allocating the ray table.\n");
+		return;
+	}
+	runWorkers(buildTableRange, (int)entries, TABLE_CHUNK_SIZE, NULL);
+}
+
+/**
+ * freeRayTable - release the baked ray table
+ *
+*/
+
+void freeRayTable(void)
+{
+	free(rayTable);
+	rayTable = NULL;
+}
+
+/**
+ * rayTableReady - check whether a baked ray table is in use
+ * Return: true if lookups can hit the table
+*/
+
+bool rayTableReady(void)
+{
+	return (rayTable != NULL);
+}
+
+/**
+ * lookupRayTable - resolve a player ray from the baked table
+ * @walk: walk initialized from the player, filled on success
+ * Return: true if the walk was resolved, false to walk the grid
+ *
+ * The distance to the stored face is the side distance the grid walk
+ * has in the cell just before it, so both give the same bits. Rays in a
+ * bucket whose samples disagreed, or that miss the stored face, which
+ * only happens near bucket boundaries, fall back to the full traversal.
+*/
+
+bool lookupRayTable(rayWalk_t *walk)
+{
+	int col, row, slot, sx, sy, bucket, hitX, hitY;
+	float distance, along;
+	uint32_t entry;
+
+	if (!rayTable)
+		return (false);
+	col = (int)view.x >> TILE_SHIFT;
+	row = (int)view.y >> TILE_SHIFT;
+	slot = cellSlot[row][col];
+	if (slot < 0)
+		return (false);
+	sx = ((int)view.x & (TILE_SIZE - 1)) >> (TILE_SHIFT - subShift);
+	sy = ((int)view.y & (TILE_SIZE - 1)) >> (TILE_SHIFT - subShift);
+	bucket = (int)(walk->rayAngle * ((1 << angleShift) / TWO_PI))
+				& ((1 << angleShift) - 1);
+	entry = rayTable[((((slot << subShift) + sy) << subShift) + sx)
+				<< angleShift | bucket];
+	if (!(entry & ENTRY_VALID))
+		return (false);
+
+	hitX = (entry & ENTRY_CELL) % MAP_NUM_COLS;
+	hitY = (entry & ENTRY_CELL) / MAP_NUM_COLS;
+	if (entry & ENTRY_VERTICAL)
+	{
+		seekRayWalk(walk, hitX - walk->stepX, hitY);
+		distance = walk->sideDistX;
+		along = view.y + distance * walk->dirY - hitY * TILE_SIZE;
+	}
+	else
+	{
+		seekRayWalk(walk, hitX, hitY - walk->stepY);
+		distance = walk->sideDistY;
+		along = view.x + distance * walk->dirX - hitX * TILE_SIZE;
+	}
+	if (!(distance >= 0 && along >= 0 && along <= TILE_SIZE))
+	{
+		seekRayWalk(walk, walk->startX, walk->startY);
+		return (false);
+	}
+
+	walk->distance = distance;
+	seekRayWalk(walk, hitX, hitY);
+	walk->vertical = (entry & ENTRY_VERTICAL) != 0;
+	walk->content = getMapValue(hitY, hitX);
+	return (true);
+}
@@ -0,0 +1,116 @@
+#include "../headers/header.h"
+
+static shade_lut_t fogTables[FOG_LEVELS];
+
+/**
+ * shadeTexel - halve the color channels of a texel, keeping alpha
+ * @texel: texel color
+ * Return: the darkened texel
+*/
+
+static color_t shadeTexel(color_t texel)
+{
+	return ((texel & 0xFF000000) | ((texel >> 1) & 0x007F7F7F));
+}
+
+/**
+ * buildFogTables - fill the per channel tables of every fog level
+ *
+ * Level 0 is the identity and the last level is black.
+*/
+
+static void buildFogTables(void)
+{
+	int level, channel, value;
+
+	for (level = 0; level < FOG_LEVELS; level++)
+	{
+		int factor = 256 * (FOG_LEVELS - 1 - level) / (FOG_LEVELS - 1);
+
+		for (channel = 0; channel < 3; channel++)
+			for (value = 0; value < 256; value++)
+				fogTables[level].channel[channel][value] =
+					(color_t)((value * factor) >> 8) << (channel * 8);
+	}
+}
+
+/**
+ * initShading - fill the shaded mip chains and build the fog tables
+ *
+ * Must run after the textures are loaded.
+*/
+
+void initShading(void)
+{
+	int i, level, j;
+
+	for (i = 0; i < NUM_TEXTURES; i++)
+	{
+		const texture_desc_t *desc = &textureDescs[i];
+
+		for (level = 0; level < desc->mipLevels; level++)
+		{
+			const color_t *plain = &textureAtlas[desc->mips[0][level]];
+			color_t *shaded = &textureAtlas[desc->mips[1][level]];
+			int size = 1 << (mipShift(desc->widthShift, level)
+							 + mipShift(desc->heightShift, level));
+
+			for (j = 0; j < size; j++)
+				shaded[j] = shadeTexel(plain[j]);
+		}
+	}
+	if (config.fogDistance > 0)
+		buildFogTables();
+}
+
+/**
+ * fogTable - get the fog table for a distance from the player
+ * @distance: perpendicular distance in pixels
+ * Return: the table of the quantized distance, or NULL when fog is off
+*/
+
+const shade_lut_t *fogTable(float distance)
+{
+	int level;
+
+	if (config.fogDistance <= 0)
+		return (NULL);
+	level = (int)(distance * FOG_LEVELS / (config.fogDistance * TILE_SIZE));
+	if (level >= FOG_LEVELS)
+		level = FOG_LEVELS - 1;
+	return (&fogTables[level < 0 ? 0 : level]);
+}
+
+/**
+ * fogTableFixed - get the fog table for a fixed point distance
+ * @distance: perpendicular distance in tiles, 16.16
+ * Return: the table of the quantized distance, or NULL when fog is off
+*/
+
+const shade_lut_t *fogTableFixed(fixed_t distance)
+{
+	int64_t level;
+
+	if (config.fogDistance <= 0)
+		return (NULL);
+	level = (int64_t)distance * FOG_LEVELS / ((int64_t)config.fogDistance * FIXED_ONE);
+	if (level >= FOG_LEVELS)
+		level = FOG_LEVELS - 1;
+	return (&fogTables[level < 0 ? 0 : level]);
+}
+
+/**
+ * fogSpan - apply a fog table to a run of pixels
+ * @pixels: first pixel
+ * @count: number of pixels
+ * @stride: pixels between consecutive pixels of the run
+ * @lut: fog table
+*/
+
+void fogSpan(color_t *pixels, int count, int stride, const shade_lut_t *lut)
+{
+	int i;
+
+	for (i = 0; i < count; i++)
+		pixels[i * stride] = fogTexel(lut, pixels[i * stride]);
+}
@@ -1,5 +1,9 @@
 #include "../headers/header.h"
 
+Texture wallTextures[NUM_TEXTURES];
+color_t *textureAtlas;
+texture_desc_t textureDescs[NUM_TEXTURES];
+
 static const char *textureFileNames[NUM_TEXTURES] = {
 	"./images/redbrick.png",
 	"./images/purplestone.png",
@@ -9,11 +13,218 @@ static const char *textureFileNames[NUM_TEXTURES] = {
 	"./images/bluestone.png",
 	"./images/wood.png",
 	"./images/eagle.png",
+	"./images/grate.png",
 };
 
+static color_t grateTexels[GRATE_SIZE * GRATE_SIZE];
+
+/**
+ * averageTexels - per channel rounded average of four texels
+ * @a: first texel
+ * @b: second texel
+ * @c: third texel
+ * @d: fourth texel
+ * Return: the averaged texel
+*/
+
+static color_t averageTexels(color_t a, color_t b, color_t c, color_t d)
+{
+	color_t result = 0;
+	int shift;
+
+	for (shift = 0; shift < 32; shift += 8)
+		result |= ((((a >> shift) & 0xFF) + ((b >> shift) & 0xFF)
+					+ ((c >> shift) & 0xFF) + ((d >> shift) & 0xFF) + 2) >> 2)
+				  << shift;
+	return (result);
+}
+
+/**
+ * sizeShift - round a texture size up to a power of two
+ * @size: size in texels
+ * Return: log2 of the rounded size, at most MAX_MIP_LEVELS - 1
+*/
+
+static int sizeShift(int size)
+{
+	int shift = 0;
+
+	while (shift < MAX_MIP_LEVELS - 1 && (1 << shift) < size)
+		shift++;
+	return (shift);
+}
+
+/**
+ * layoutTexture - fill the descriptor of a texture and reserve its texels
+ * @desc: descriptor to fill
+ * @texture: loaded texture
+ * @size: texels reserved in the atlas so far, updated
+ *
+ * A texture takes its row-major texels, then its plain mip chain, then
+ * its shaded mip chain, starting on a cache line.
+*/
+
+static void layoutTexture(texture_desc_t *desc, const Texture *texture,
+	uint32_t *size)
+{
+	int chain, level, widthShift, heightShift;
+
+	desc->widthShift = sizeShift(texture->width);
+	desc->heightShift = sizeShift(texture->height);
+	desc->mipLevels = 1 + (desc->widthShift > desc->heightShift
+						   ? desc->widthShift : desc->heightShift);
+	*size = (*size + ATLAS_ALIGN - 1) & ~(uint32_t)(ATLAS_ALIGN - 1);
+	desc->texels = *size;
+	*size += 1 << (desc->widthShift + desc->heightShift);
+	for (chain = 0; chain < 2; chain++)
+		for (level = 0; level < desc->mipLevels; level++)
+		{
+			widthShift = mipShift(desc->widthShift, level);
+			heightShift = mipShift(desc->heightShift, level);
+			desc->mips[chain][level] = *size;
+			*size += 1 << (widthShift + heightShift);
+		}
+}
+
+/**
+ * buildMipLevel - downsample the previous mip level with a 2x2 box filter
+ * @desc: descriptor of the texture
+ * @level: level to fill, at least 1
+*/
+
+static void buildMipLevel(const texture_desc_t *desc, int level)
+{
+	const color_t *parent = &textureAtlas[desc->mips[0][level - 1]];
+	color_t *mip = &textureAtlas[desc->mips[0][level]];
+	int width = 1 << mipShift(desc->widthShift, level);
+	int heightShift = mipShift(desc->heightShift, level);
+	int parentWidth = 1 << mipShift(desc->widthShift, level - 1);
+	int parentShift = mipShift(desc->heightShift, level - 1);
+	int u, v;
+
+	for (u = 0; u < width; u++)
+		for (v = 0; v < 1 << heightShift; v++)
+		{
+			int u0 = 2 * u, v0 = 2 * v;
+			int u1 = u0 + 1 < parentWidth ? u0 + 1 : u0;
+			int v1 = v0 + 1 < 1 << parentShift ? v0 + 1 : v0;
+
+			mip[(u << heightShift) + v] = averageTexels(
+				parent[(u0 << parentShift) + v0], parent[(u0 << parentShift) + v1],
+				parent[(u1 << parentShift) + v0], parent[(u1 << parentShift) + v1]);
+		}
+}
+
+/**
+ * packTexture - copy a texture into its place in the atlas
+ * @desc: descriptor of the texture
+ * @texture: loaded texture
+ *
+ * Sizes that are not a power of two are stretched to the next one.
+*/
+
+static void packTexture(const texture_desc_t *desc, const Texture *texture)
+{
+	color_t *texels = &textureAtlas[desc->texels];
+	color_t *columns = &textureAtlas[desc->mips[0][0]];
+	int u, v, level;
+
+	for (v = 0; v < 1 << desc->heightShift; v++)
+		for (u = 0; u < 1 << desc->widthShift; u++)
+		{
+			color_t texel = texture->texture_buffer[
+				((v * texture->height) >> desc->heightShift) * texture->width
+				+ ((u * texture->width) >> desc->widthShift)];
+
+			texels[(v << desc->widthShift) + u] = texel;
+			columns[(u << desc->heightShift) + v] = texel;
+		}
+	for (level = 1; level < desc->mipLevels; level++)
+		buildMipLevel(desc, level);
+}
+
+/**
+ * buildTextureAtlas - pack every loaded texture into one aligned atlas
+ *
+ * Textures that failed to load keep a descriptor with no mip levels.
+ * When none loaded, no atlas is allocated and textureAtlas stays NULL.
+*/
+
+static void buildTextureAtlas(void)
+{
+	uint32_t size = 0;
+	int i;
+
+	for (i = 0; i < NUM_TEXTURES; i++)
+		if (wallTextures[i].texture_buffer != NULL)
+			layoutTexture(&textureDescs[i], &wallTextures[i], &size);
+	/* with nothing loaded every descriptor is already empty */
+	if (size == 0)
+		return;
+	size = (size + ATLAS_ALIGN - 1) & ~(uint32_t)(ATLAS_ALIGN - 1);
+	textureAtlas = aligned_alloc(ATLAS_ALIGN * sizeof(color_t),
+								 size * sizeof(color_t));
+	if (textureAtlas == NULL)
+	{
+		fprintf(stderr, "Error allocating the texture atlas.\n");
+		memset(textureDescs, 0, sizeof(textureDescs));
+		return;
+	}
+	for (i = 0; i < NUM_TEXTURES; i++)
+		if (textureDescs[i].mipLevels > 0)
+			packTexture(&textureDescs[i], &wallTextures[i]);
+}
+
+/**
+ * convertTexture - rewrite decoded RGBA bytes in the framebuffer's format
+ * @texture: loaded texture, converted in place
+ *
+ * Done once at load so neither drawing nor presenting swizzles pixels.
+*/
+
+static void convertTexture(Texture *texture)
+{
+	uint8_t *bytes = (uint8_t *)texture->texture_buffer;
+	int i;
+
+	for (i = 0; i < texture->width * texture->height; i++)
+		texture->texture_buffer[i] = packColor(bytes[i * 4], bytes[i * 4 + 1],
+			bytes[i * 4 + 2], bytes[i * 4 + 3]);
+}
+
+/**
+ * drawGrate - draw the grate texture when its image is missing
+ * @texture: texture to fill
+ *
+ * Bars every 16 texels in both directions, lit on one edge. The texels
+ * between them are fully transparent but keep the bar color, so the
+ * mip levels fade the bars instead of darkening them.
+*/
+
+static void drawGrate(Texture *texture)
+{
+	int u, v, shade;
+
+	for (v = 0; v < GRATE_SIZE; v++)
+		for (u = 0; u < GRATE_SIZE; u++)
+		{
+			int barU = (u & 15) < 4, barV = (v & 15) < 4;
+
+			shade = (u & 15) == 0 || (v & 15) == 0 ? 170 : 110;
+			grateTexels[v * GRATE_SIZE + u] = packColor(shade, shade, shade + 10,
+				barU || barV ? 255 : 0);
+		}
+	texture->width = GRATE_SIZE;
+	texture->height = GRATE_SIZE;
+	texture->texture_buffer = grateTexels;
+}
+
 /**
  * WallTexturesready - load textures in the respective position
  *
+ * The decoded images are converted to the framebuffer's pixel format and
+ * then packed into the texture atlas. The see-through grate is drawn in
+ * code when its image is missing, so the masked passes always have it.
 */
 void WallTexturesready(void)
 {
@@ -34,10 +245,16 @@ void WallTexturesready(void)
 				wallTextures[i].width = upng_get_width(upng);
 				wallTextures[i].height = upng_get_height(upng);
 				wallTextures[i].texture_buffer = (color_t *)upng_get_buffer(upng);
+				if (upng_get_format(upng) == UPNG_RGBA8)
+					convertTexture(&wallTextures[i]);
 			}
+			else
+				upng_free(upng);
 		}
+		if (wallTextures[i].texture_buffer == NULL && i == GRATE_TEXTURE)
+			drawGrate(&wallTextures[i]);
 	}
-
+	buildTextureAtlas();
 }
 
 /**
@@ -50,5 +267,7 @@ void freeWallTextures(void)
 	int i;
 
 	for (i = 0; i < NUM_TEXTURES; i++)
-		upng_free(wallTextures[i].upngTexture);
+		if (wallTextures[i].upngTexture != NULL)
+			upng_free(wallTextures[i].upngTexture);
+	free(textureAtlas);
 }
@@ -1,139 +1,348 @@
 #include "../headers/header.h"
 
+static float viewDirX, viewDirY;
+static SDL_atomic_t planeSamples;
+
 /**
- * changeColorIntensity - change color intensity
- * based on a factor value between 0 and 1
- * @factor: intensity factor
- * @color: color for intensity
+ * samplePlane - sample the floor or ceiling texture under a screen column
+ * @plane: world position at column 0 and its per-column step
+ * @x: screen column
+ * @texture: plane texture
+ * @scale: world units per texture repeat
+ * Return: the texel
 */
 
-void changeColorIntensity(color_t *color, float factor)
+static inline color_t samplePlane(const plane_row_t *plane, int x,
+	const texture_desc_t *texture, int scale)
 {
-	color_t a = (*color & 0xFF000000);
-	color_t r = (*color & 0x00FF0000) * factor;
-	color_t g = (*color & 0x0000FF00) * factor;
-	color_t b = (*color & 0x000000FF) * factor;
+	int widthShift = texture->widthShift, heightShift = texture->heightShift;
+	int textureOffsetX, textureOffsetY;
+
+	if (config.fixedPoint)
+	{
+		int64_t worldX = plane->xFx + x * plane->stepXFx;
+		int64_t worldY = plane->yFx + x * plane->stepYFx;
+
+		textureOffsetX = (int)(((worldX < 0 ? -worldX : worldX) * TILE_SIZE) >> 32);
+		textureOffsetY = (int)(((worldY < 0 ? -worldY : worldY) * TILE_SIZE) >> 32);
+	}
+	else
+	{
+		textureOffsetX = abs((int)(plane->x + x * plane->stepX));
+		textureOffsetY = abs((int)(plane->y + x * plane->stepY));
+	}
+
+	textureOffsetX = ((textureOffsetX << widthShift) / scale)
+						& ((1 << widthShift) - 1);
+	textureOffsetY = ((textureOffsetY << heightShift) / scale)
+						& ((1 << heightShift) - 1);
 
-	*color = a | (r & 0x00FF0000) | (g & 0x0000FF00) | (b & 0x000000FF);
+	return (textureAtlas[texture->texels + (textureOffsetY << widthShift)
+						 + textureOffsetX]);
 }
 
 /**
- * renderFloor - render floor projection
+ * renderPlaneSpan - texture one run of a floor or ceiling row
+ * @y: screen row
+ * @x0: first column of the run
+ * @x1: one past the last column of the run
+ * @plane: world position at column 0 and its per-column step
+ * @texture: plane texture
+ * @scale: world units per texture repeat
+ * @rate: columns sharing one sample, a power of two
  *
- * @WallBottomPixel: wall bottom pixel
- * @texelColor: texture color for current pixel
- * @x: current element in the rays array
+ * The world point of a row moves linearly across the screen, so each
+ * pixel costs a multiply-add instead of a trig call and a divide. Shared
+ * samples are taken on a grid aligned to the rate so they do not crawl
+ * with the span edges.
+ * Return: the number of texels sampled
 */
 
-void renderFloor(int wallBottomPixel, color_t *texelColor, int x)
+static int renderPlaneSpan(int y, int x0, int x1, const plane_row_t *plane,
+	const texture_desc_t *texture, int scale, int rate)
 {
-	int y, texture_height, texture_width, textureOffsetY, textureOffsetX;
-	float distance, ratio;
+	color_t *row = framebufferAt(0, y);
+	int x, next, samples = 0;
 
-	texture_width = wallTextures[3].width;
-	texture_height = wallTextures[3].height;
-
-	for (y = wallBottomPixel - 1; y < SCREEN_HEIGHT; y++)
+	if (x1 <= x0)
+		return (0);
+	/* nothing else covers the run, so a missing texture leaves it black */
+	if (texture->mipLevels == 0)
 	{
-		ratio = player.height / (y - SCREEN_HEIGHT / 2);
-		distance = (ratio * PROJ_PLANE)
-					/ cos(rays[x].rayAngle - player.rotationAngle);
+		fillSpan(&row[x0 * framebuffer.xStride], x1 - x0, framebuffer.xStride,
+				 BACKGROUND_COLOR);
+		return (0);
+	}
+	countWrites(&row[x0 * framebuffer.xStride], x1 - x0, framebuffer.xStride);
+	if (rate == 1)
+	{
+		for (x = x0; x < x1; x++)
+			row[x * framebuffer.xStride] = samplePlane(plane, x, texture, scale);
+		return (x1 - x0);
+	}
+	for (x = x0; x < x1; samples++)
+	{
+		color_t texel = samplePlane(plane, x & ~(rate - 1), texture, scale);
 
-		textureOffsetY = (int)abs((distance * sin(rays[x].rayAngle)) + player.y);
-		textureOffsetX = (int)abs((distance * cos(rays[x].rayAngle)) + player.x);
+		next = (x | (rate - 1)) + 1;
+		for (; x < next && x < x1; x++)
+			row[x * framebuffer.xStride] = texel;
+	}
+	return (samples);
+}
 
-		textureOffsetX = (int)(abs(textureOffsetX * texture_width / 30)
-								% texture_width);
-		textureOffsetY = (int)(abs(textureOffsetY * texture_height / 30)
-								% texture_height);
+/**
+ * uncoveredSpan - find the next run of a row the walls leave uncovered
+ * @y: screen row
+ * @floor: true for floor rows, false for ceiling rows
+ * @x: column to search from, set to one past the end of the run
+ * @x1: one past the last column of the band
+ * Return: the first column of the run, equal to *x if there is none
+*/
+
+static int uncoveredSpan(int y, bool floor, int *x, int x1)
+{
+	int start;
 
-		*texelColor = wallTextures[4].
-					  texture_buffer[(texture_width * textureOffsetY) + textureOffsetX];
-		drawPixel(x, y, *texelColor);
+	while (*x < x1 && (floor ? y < gbuffer.stripBottom[0][*x]
+						   : y >= gbuffer.stripTop[0][*x]))
+		(*x)++;
+	start = *x;
+	while (*x < x1 && (floor ? y >= gbuffer.stripBottom[0][*x]
+						   : y < gbuffer.stripTop[0][*x]))
+		(*x)++;
+	return (start);
+}
+
+/**
+ * renderPlaneRow - texture the uncovered spans of one floor or ceiling row
+ * @y: screen row
+ * @floor: true for the floor (rows below the walls), false for the ceiling
+ * @x0: first column of the band
+ * @x1: one past the last column of the band
+ * @rate: columns sharing one sample
+ * Return: the number of texels sampled
+*/
+
+static int renderPlaneRow(int y, bool floor, int x0, int x1, int rate)
+{
+	float distance = floor ? camera.rowDistance[y] : -camera.rowDistance[y];
+	plane_row_t plane;
+	const shade_lut_t *fog;
+	int x = x0, start, samples = 0;
+
+	if (config.fixedPoint)
+	{
+		fixedPlaneRow(fixedRowDistance(y), &plane);
+		fog = fogTableFixed(fixedRowDistance(y));
+	}
+	else
+	{
+		plane.stepX = -viewDirY * distance / camera.projPlane;
+		plane.stepY = viewDirX * distance / camera.projPlane;
+		plane.x = view.x + distance * viewDirX - plane.stepX * (NUM_RAYS / 2);
+		plane.y = view.y + distance * viewDirY - plane.stepY * (NUM_RAYS / 2);
+		fog = fogTable(distance);
+	}
+
+	while (x < x1)
+	{
+		start = uncoveredSpan(y, floor, &x, x1);
+		if (floor)
+			samples += renderPlaneSpan(y, start, x, &plane, &textureDescs[4], 30, rate);
+		else
+			samples += renderPlaneSpan(y, start, x, &plane, &textureDescs[6], 40, rate);
+		if (fog != NULL)
+			fogSpan(framebufferAt(start, y), x - start, framebuffer.xStride, fog);
 	}
+	return (samples);
 }
 
 /**
- * renderCeil - render Ceil projection
- * @WallTopPixel: wall top pixel
- * @texelColor: texture color for current pixel
- * @x: current element in the rays array
+ * copyPlaneRow - fill the uncovered spans of a row from a shaded row
+ * @source: shaded row, uncovered wherever the filled row is
+ * @y: row to fill
+ * @floor: true for floor rows, false for ceiling rows
+ * @x0: first column of the band
+ * @x1: one past the last column of the band
 */
 
-void renderCeil(int wallTopPixel, color_t *texelColor, int x)
+static void copyPlaneRow(int source, int y, bool floor, int x0, int x1)
 {
-	int y, texture_width, texture_height, textureOffsetY, textureOffsetX;
+	const color_t *src = framebufferAt(0, source);
+	color_t *dst = framebufferAt(0, y);
+	int x = x0, start;
 
-	texture_width = wallTextures[3].width;
-	texture_height = wallTextures[3].height;
+	while (x < x1)
+	{
+		start = uncoveredSpan(y, floor, &x, x1);
+		countWrites(dst + start * framebuffer.xStride, x - start, framebuffer.xStride);
+		if (framebuffer.xStride == 1)
+			memcpy(dst + start, src + start, sizeof(color_t) * (x - start));
+		else
+			for (; start < x; start++)
+				dst[start * framebuffer.xStride] = src[start * framebuffer.xStride];
+	}
+}
 
-	for (y = 0; y < wallTopPixel; y++)
+/**
+ * planeRate - pick the shading rate of a floor or ceiling row
+ * @y: screen row
+ * Return: the number of columns and rows sharing one sample
+*/
+
+static int planeRate(int y)
+{
+	float distance = fabsf(camera.rowDistance[y]);
+
+	if (config.fixedPoint)
 	{
-		float distance, ratio;
+		if (config.quarterRateTiles > 0
+			&& fixedRowDistance(y) >= config.quarterRateTiles * FIXED_ONE)
+			return (4);
+		if (config.halfRateTiles > 0
+			&& fixedRowDistance(y) >= config.halfRateTiles * FIXED_ONE)
+			return (2);
+		return (1);
+	}
+	if (config.quarterRateTiles > 0 && distance >= config.quarterRateTiles * TILE_SIZE)
+		return (4);
+	if (config.halfRateTiles > 0 && distance >= config.halfRateTiles * TILE_SIZE)
+		return (2);
+	return (1);
+}
+
+/**
+ * renderFloorCeil - render floor and ceiling projection row by row
+ * @x0: first column of the band
+ * @x1: one past the last column of the band
+ *
+ * Walls never reach past the horizon, so ceiling rows only need to look
+ * at wall tops and floor rows at wall bottoms. Distant rows are shaded in
+ * blocks of rate x rate pixels: the block row farthest from the horizon
+ * is sampled and copied to the others, whose uncovered spans it contains.
+ * Return: the number of texels sampled
+*/
 
-		ratio = player.height / (y - SCREEN_HEIGHT / 2);
-		distance = (ratio * PROJ_PLANE)
-					/ cos(rays[x].rayAngle - player.rotationAngle);
+static int renderFloorCeil(int x0, int x1)
+{
+	int y, row, rate, samples = 0;
 
-		textureOffsetY = (int)abs((-distance * sin(rays[x].rayAngle)) + player.y);
-		textureOffsetX = (int)abs((-distance * cos(rays[x].rayAngle)) + player.x);
+	for (y = 0; y < SCREEN_HEIGHT / 2; y += rate)
+	{
+		rate = planeRate(y);
+		samples += renderPlaneRow(y, false, x0, x1, rate);
+		for (row = y + 1; row < y + rate && row < SCREEN_HEIGHT / 2; row++)
+			copyPlaneRow(y, row, false, x0, x1);
+	}
+	for (y = SCREEN_HEIGHT - 1; y >= SCREEN_HEIGHT / 2; y -= rate)
+	{
+		rate = planeRate(y);
+		samples += renderPlaneRow(y, true, x0, x1, rate);
+		for (row = y - 1; row > y - rate && row >= SCREEN_HEIGHT / 2; row--)
+			copyPlaneRow(y, row, true, x0, x1);
+	}
+	return (samples);
+}
 
-		textureOffsetX = (int)(abs(textureOffsetX * texture_width / 40)
-								% texture_width);
-		textureOffsetY = (int)(abs(textureOffsetY * texture_height / 40)
-								% texture_height);
+/**
+ * shadeStrip - draw the textured strip of one G-buffer layer
+ * @x: screen column
+ * @layer: G-buffer layer
+ *
+ * Strips taller than the screen start their texture walk part way down
+ * the column instead of stepping through the rows above the screen.
+ * Shorter strips sample a mip level about as tall as they are. Layers in
+ * front of the opaque hit skip their fully transparent texels.
+*/
 
-		*texelColor = wallTextures[6].
-					  texture_buffer[(texture_width * textureOffsetY) + textureOffsetX];
-		drawPixel(x, y, *texelColor);
+static void shadeStrip(int x, int layer)
+{
+	const texture_desc_t *texture = &textureDescs[gbuffer.material[layer][x] - 1];
+	int wallStripHeight = gbuffer.stripHeight[layer][x];
+	int wallTopPixel = gbuffer.stripTop[layer][x];
+	int wallBottomPixel = gbuffer.stripBottom[layer][x];
+	int distanceFromTop, level = 0, heightShift, lastRow;
+	column_span_t span;
 
+	if (wallBottomPixel <= wallTopPixel)
+		return;
+	/* an opaque strip is the only thing covering its pixels */
+	if (texture->mipLevels == 0)
+	{
+		if (layer == 0)
+			fillSpan(framebufferAt(x, wallTopPixel), wallBottomPixel - wallTopPixel,
+					 framebuffer.yStride, BACKGROUND_COLOR);
+		return;
 	}
+	distanceFromTop = wallTopPixel + (wallStripHeight / 2) - (SCREEN_HEIGHT / 2);
+
+	/* the smallest level that still has a texel for every pixel */
+	while (level + 1 < texture->mipLevels
+		   && 1 << mipShift(texture->heightShift, level + 1) >= wallStripHeight)
+		level++;
+	heightShift = mipShift(texture->heightShift, level);
+
+	span.src = &textureAtlas[texture->mips[gbuffer.side[layer][x]][level]
+		+ (((gbuffer.texU[layer][x] << texture->widthShift) >> (TILE_SHIFT + level))
+		   << heightShift)];
+	span.dst = framebufferAt(x, wallTopPixel);
+	/* rounding up keeps exact texel boundaries where the float walk had them */
+	if (config.fixedPoint)
+		span.step = (1 << (heightShift + FIXED_SHIFT)) / wallStripHeight;
+	else
+		span.step = ((1 << (heightShift + FIXED_SHIFT)) + wallStripHeight - 1)
+					/ wallStripHeight;
+	/* the rounded up step must not carry the last row past the texture */
+	lastRow = distanceFromTop + (wallBottomPixel - wallTopPixel) - 1;
+	if (lastRow > 0 && (int64_t)lastRow * span.step >= 1 << (heightShift + FIXED_SHIFT))
+		span.step = ((1 << (heightShift + FIXED_SHIFT)) - 1) / lastRow;
+	span.v = distanceFromTop * span.step;
+	span.fog = config.fixedPoint ? fogTableFixed(gbuffer.depthFx[layer][x])
+		: fogTable(gbuffer.depth[layer][x]);
+	countWrites(span.dst, wallBottomPixel - wallTopPixel, framebuffer.yStride);
+	getColumnKernel(span.fog != NULL, layer > 0)(&span,
+		wallBottomPixel - wallTopPixel);
 }
 
 /**
- * renderWall - render wall projection
+ * renderBand - shade a band of columns from the G-buffer
+ * @start: first column
+ * @end: one past the last column
+ * @data: unused
  *
+ * See-through walls in front of the opaque hit are composited back to
+ * front over it.
 */
-void renderWall(void)
+
+static void renderBand(int start, int end, void *data)
 {
-	int x, y, texNum, texture_width, texture_height,
-		textureOffsetX, wallBottomPixel, wallStripHeight,
-		wallTopPixel, distanceFromTop, textureOffsetY;
-	float perpDistance, projectedWallHeight;
-	color_t texelColor;
+	int x, layer, samples;
 
-	for (x = 0; x < NUM_RAYS; x++)
+	(void)data;
+	samples = renderFloorCeil(start, end);
+	if (config.benchFrames > 0)
+		SDL_AtomicAdd(&planeSamples, samples);
+	for (x = start; x < end; x++)
 	{
-		perpDistance = rays[x].distance * cos(rays[x].rayAngle
-							- player.rotationAngle);
-		projectedWallHeight = (TILE_SIZE / perpDistance) * PROJ_PLANE;
-		wallStripHeight = (int)projectedWallHeight;
-		wallTopPixel = (SCREEN_HEIGHT / 2) - (wallStripHeight / 2);
-		wallTopPixel = wallTopPixel < 0 ? 0 : wallTopPixel;
-		wallBottomPixel = (SCREEN_HEIGHT / 2) + (wallStripHeight / 2);
-		wallBottomPixel = wallBottomPixel > SCREEN_HEIGHT
-							? SCREEN_HEIGHT : wallBottomPixel;
-		texNum = rays[x].wallHitContent - 1;
-		texture_width = wallTextures[texNum].width;
-		texture_height = wallTextures[texNum].height;
-		renderFloor(wallBottomPixel, &texelColor, x);
-		renderCeil(wallTopPixel, &texelColor, x);
-
-		if (rays[x].wasHitVertical)
-			textureOffsetX = (int)rays[x].wallHitY % TILE_SIZE;
-		else
-			textureOffsetX = (int)rays[x].wallHitX % TILE_SIZE;
-
-		for (y = wallTopPixel; y < wallBottomPixel; y++)
-		{
-			distanceFromTop = y + (wallStripHeight / 2) - (SCREEN_HEIGHT / 2);
-			textureOffsetY = distanceFromTop *
-								((float)texture_height / wallStripHeight);
-			texelColor = wallTextures[texNum].
-						 texture_buffer[(texture_width * textureOffsetY) + textureOffsetX];
-			if (rays[x].wasHitVertical)
-				changeColorIntensity(&texelColor, 0.5);
-			drawPixel(x, y, texelColor);
-		}
+		shadeStrip(x, 0);
+		for (layer = gbuffer.layers[x]; layer > 0; layer--)
+			shadeStrip(x, layer);
 	}
 }
+
+/**
+ * renderWall - render wall projection
+ *
+ * Columns only depend on their own ray, so bands of them are drawn in
+ * parallel on the worker pool; this returns once every band is done.
+ * Together the bands write every pixel of the frame.
+*/
+void renderWall(void)
+{
+	viewDirX = cos(view.angle);
+	viewDirY = sin(view.angle);
+	runWorkers(renderBand, NUM_RAYS, RENDER_BAND_SIZE, NULL);
+	checkOverdraw();
+	benchCount(BENCH_PLANE_TEXELS, SDL_AtomicSet(&planeSamples, 0));
+}
@@ -0,0 +1,176 @@
+#include "../headers/header.h"
+
+/* Strips drawn per variant by benchWallKernels */
+#define KERNEL_BENCH_STRIPS 20000
+/* Framebuffer layouts: packed rows, rows with a texture pitch, columns */
+#define KERNEL_LAYOUTS 3
+/* Row padding of the pitched layout in benchWallKernels */
+#define KERNEL_BENCH_PAD 16
+/* Smallest and largest texture sizes timed by benchWallKernels, log2 */
+#define KERNEL_MIN_SHIFT 6
+#define KERNEL_MAX_SHIFT 9
+
+/*
+ * DEFINE_COLUMN_KERNEL - define a column span kernel for one combination of
+ * destination stride, fog and transparency. The options are constants, so
+ * each expansion compiles to a loop with no branches on them.
+ */
+#define DEFINE_COLUMN_KERNEL(name, DST_STRIDE, FOG, MASKED)                 \
+static void name(const column_span_t *span, int count)                     \
+{                                                                          \
+	const color_t *src = span->src;                                         \
+	color_t *dst = span->dst;                                               \
+	fixed_t v = span->v;                                                    \
+	int i;                                                                  \
+                                                                           \
+	for (i = 0; i < count; i++, v += span->step)                            \
+	{                                                                       \
+		color_t texel = src[v >> FIXED_SHIFT];                              \
+                                                                           \
+		if (FOG)                                                            \
+			texel = fogTexel(span->fog, texel);                             \
+		if (MASKED)                                                         \
+			texel = (texel & 0xFF000000) ? texel : dst[i * (DST_STRIDE)];   \
+		dst[i * (DST_STRIDE)] = texel;                                      \
+	}                                                                       \
+}
+
+DEFINE_COLUMN_KERNEL(spanRows, SCREEN_WIDTH, 0, 0)
+DEFINE_COLUMN_KERNEL(spanRowsMasked, SCREEN_WIDTH, 0, 1)
+DEFINE_COLUMN_KERNEL(spanRowsFog, SCREEN_WIDTH, 1, 0)
+DEFINE_COLUMN_KERNEL(spanRowsFogMasked, SCREEN_WIDTH, 1, 1)
+DEFINE_COLUMN_KERNEL(spanPitched, framebuffer.yStride, 0, 0)
+DEFINE_COLUMN_KERNEL(spanPitchedMasked, framebuffer.yStride, 0, 1)
+DEFINE_COLUMN_KERNEL(spanPitchedFog, framebuffer.yStride, 1, 0)
+DEFINE_COLUMN_KERNEL(spanPitchedFogMasked, framebuffer.yStride, 1, 1)
+DEFINE_COLUMN_KERNEL(spanColumns, 1, 0, 0)
+DEFINE_COLUMN_KERNEL(spanColumnsMasked, 1, 0, 1)
+DEFINE_COLUMN_KERNEL(spanColumnsFog, 1, 1, 0)
+DEFINE_COLUMN_KERNEL(spanColumnsFogMasked, 1, 1, 1)
+
+/* indexed by [layout][fog][masked] */
+static const column_kernel_t columnKernels[KERNEL_LAYOUTS][2][2] = {
+	{{spanRows, spanRowsMasked}, {spanRowsFog, spanRowsFogMasked}},
+	{{spanPitched, spanPitchedMasked}, {spanPitchedFog, spanPitchedFogMasked}},
+	{{spanColumns, spanColumnsMasked}, {spanColumnsFog, spanColumnsFogMasked}},
+};
+
+static const char *kernelNames[KERNEL_LAYOUTS][2][2] = {
+	{{"rows", "rows masked"}, {"rows fog", "rows fog masked"}},
+	{{"pitched", "pitched masked"}, {"pitched fog", "pitched fog masked"}},
+	{{"columns", "columns masked"}, {"columns fog", "columns fog masked"}},
+};
+
+/**
+ * getColumnKernel - pick the span kernel for a wall strip
+ * @fog: the strip is fogged
+ * @masked: transparent texels keep the pixels behind them
+ * Return: the kernel matching the options and the framebuffer layout
+*/
+
+column_kernel_t getColumnKernel(bool fog, bool masked)
+{
+	int layout = framebuffer.yStride == 1 ? 2 : framebuffer.yStride != SCREEN_WIDTH;
+
+	return (columnKernels[layout][fog][masked]);
+}
+
+/**
+ * timeKernel - measure the throughput of one span kernel
+ * @kernel: kernel to time
+ * @layout: framebuffer layout the kernel writes
+ * @texels: first column-major texel of the texture
+ * @sizeShift: log2 of the texture width and height
+ * @clipped: draw strips taller than the screen, entering part way down
+ * Return: millions of pixels drawn per second
+*/
+
+static double timeKernel(column_kernel_t kernel, int layout, const color_t *texels,
+						 int sizeShift, bool clipped)
+{
+	static shade_lut_t lut;
+	color_t *scratch = framebuffer.pixels;
+	long pixels = 0;
+	Uint64 start;
+	int i, j;
+
+	for (i = 0; i < 3; i++)
+		for (j = 0; j < 256; j++)
+			lut.channel[i][j] = (color_t)j << (i * 8);
+	start = SDL_GetPerformanceCounter();
+	for (i = 0; i < KERNEL_BENCH_STRIPS; i++)
+	{
+		column_span_t span;
+		int x = i % SCREEN_WIDTH, count = SCREEN_HEIGHT - i % 64;
+		int height = clipped ? 2 * SCREEN_HEIGHT + i % 64 * 8 : count;
+
+		if (clipped)
+			count = SCREEN_HEIGHT;
+		span.src = &texels[(x % (1 << sizeShift)) << sizeShift];
+		span.dst = layout == 2 ? &scratch[x * SCREEN_HEIGHT] : &scratch[x];
+		span.step = (1 << (sizeShift + FIXED_SHIFT)) / height;
+		span.v = (height - count) / 2 * span.step;
+		span.fog = &lut;
+		kernel(&span, count);
+		pixels += count;
+	}
+	return (pixels / ((SDL_GetPerformanceCounter() - start)
+			/ (double)SDL_GetPerformanceFrequency()) / 1e6);
+}
+
+/**
+ * benchWallKernels - print the throughput of every span kernel variant
+ *
+ * Each variant draws the same strips of the first texture into a scratch
+ * framebuffer, stepping through its column at several scales. The
+ * pitched variants get rows padded by KERNEL_BENCH_PAD pixels. The plain
+ * kernel of each layout is then timed on square textures of every size
+ * from KERNEL_MIN_SHIFT to KERNEL_MAX_SHIFT, on strips that fit the
+ * screen and on strips clipped by it.
+*/
+
+void benchWallKernels(void)
+{
+	const texture_desc_t *texture = &textureDescs[0];
+	framebuffer_t saved = framebuffer;
+	color_t *scratch, *texels;
+	int layout, fog, masked, clipped, shift, i;
+
+	scratch = malloc(sizeof(color_t) * (SCREEN_WIDTH + KERNEL_BENCH_PAD) * SCREEN_HEIGHT);
+	texels = malloc(sizeof(color_t) << (2 * KERNEL_MAX_SHIFT));
+	if (texture->mipLevels == 0 || scratch == NULL || texels == NULL)
+	{
+		free(scratch);
+		free(texels);
+		return;
+	}
+	for (i = 0; i < 1 << (2 * KERNEL_MAX_SHIFT); i++)
+		texels[i] = 0xFF000000 | (color_t)i * 2654435761u;
+	framebuffer.pixels = scratch;
+	framebuffer.xStride = 1;
+	framebuffer.yStride = SCREEN_WIDTH + KERNEL_BENCH_PAD;
+	for (layout = 0; layout < KERNEL_LAYOUTS; layout++)
+		for (fog = 0; fog < 2; fog++)
+			for (masked = 0; masked < 2; masked++)
+				printf("  %-20s %9.1f Mpixel/s\n", kernelNames[layout][fog][masked],
+					   timeKernel(columnKernels[layout][fog][masked], layout,
+								  &textureAtlas[texture->mips[0][0]],
+								  texture->heightShift, false));
+	printf("  %-20s", "Mpixel/s by size");
+	for (shift = KERNEL_MIN_SHIFT; shift <= KERNEL_MAX_SHIFT; shift++)
+		printf(" %7d", 1 << shift);
+	printf("\n");
+	for (layout = 0; layout < KERNEL_LAYOUTS; layout++)
+		for (clipped = 0; clipped < 2; clipped++)
+		{
+			printf("  %-12s %-7s", kernelNames[layout][0][0],
+				   clipped ? "clipped" : "fits");
+			for (shift = KERNEL_MIN_SHIFT; shift <= KERNEL_MAX_SHIFT; shift++)
+				printf(" %7.1f", timeKernel(columnKernels[layout][0][0], layout,
+											texels, shift, clipped));
+			printf("\n");
+		}
+	framebuffer = saved;
+	free(texels);
+	free(scratch);
+}
@@ -1,9 +1,155 @@
 #include "../headers/header.h"
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+/* Side of the square tiles the framebuffer is transposed in */
+#define TRANSPOSE_BLOCK 16
+
+framebuffer_t framebuffer;
+pixel_format_t pixelFormat = {SDL_PIXELFORMAT_RGBA32, 0, 8, 16, 24};
 
 static SDL_Renderer *renderer;
-static color_t *colorBuffer;
+static color_t *colorBuffers[MAX_PIPELINE_DEPTH];
+static color_t *transposeBuffer;
 static SDL_Texture *colorBufferTexture;
 static SDL_Window *window;
+static bool textureLocked;
+static SDL_Surface *windowSurface;
+static SDL_Surface *frameSurface;
+static present_mode_t presentMode;
+static int presentScale, presentLeft, presentTop;
+static char presentName[64];
+
+/**
+ * useColorBuffer - point the framebuffer at a malloc'd colorbuffer
+ * @slot: pipeline slot of the colorbuffer
+*/
+
+static void useColorBuffer(int slot)
+{
+	framebuffer.pixels = colorBuffers[slot];
+	framebuffer.xStride = config.columnMajor ? SCREEN_HEIGHT : 1;
+	framebuffer.yStride = config.columnMajor ? 1 : SCREEN_WIDTH;
+}
+
+/**
+ * usePixelFormat - pick the framebuffer format matching the window's
+ * @native: SDL_PIXELFORMAT_* of the window
+ *
+ * 32-bit RGB formats are used as they are, with the padding byte taken
+ * as alpha, so presenting is a straight copy. Anything else keeps RGBA32
+ * and is converted by SDL at present.
+*/
+
+static void usePixelFormat(Uint32 native)
+{
+	SDL_PixelFormat *format;
+
+	if (native == SDL_PIXELFORMAT_ARGB8888 || native == SDL_PIXELFORMAT_RGB888)
+		pixelFormat.format = SDL_PIXELFORMAT_ARGB8888;
+	else if (native == SDL_PIXELFORMAT_ABGR8888 || native == SDL_PIXELFORMAT_BGR888)
+		pixelFormat.format = SDL_PIXELFORMAT_ABGR8888;
+	else
+		pixelFormat.format = SDL_PIXELFORMAT_RGBA32;
+	format = SDL_AllocFormat(pixelFormat.format);
+	if (!format)
+		return;
+	pixelFormat.rShift = format->Rshift;
+	pixelFormat.gShift = format->Gshift;
+	pixelFormat.bShift = format->Bshift;
+	pixelFormat.aShift = format->Ashift;
+	SDL_FreeFormat(format);
+}
+
+/**
+ * createRenderer - set up the SDL_Renderer present backend
+ *
+ * Accelerated renderers are tried before the software one, the order
+ * SDL itself uses. This is not a speed choice: MAZE_BENCH prints the
+ * renderer in use next to the present time for comparing them.
+ * Return: true in case of success, false if it fails
+*/
+
+static bool createRenderer(void)
+{
+	SDL_RendererInfo info;
+
+	renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED);
+	if (!renderer)
+		renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_SOFTWARE);
+	if (!renderer)
+	{
+		fprintf(stderr, "Error creating SDL renderer.\n");
+		return (false);
+	}
+	SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
+	if (SDL_GetRendererInfo(renderer, &info) != 0)
+		info.name = "unknown";
+	snprintf(presentName, sizeof(presentName), "renderer (%s)", info.name);
+
+	/* create an SDL_Texture to display the colorbuffer */
+	usePixelFormat(SDL_GetWindowPixelFormat(window));
+	colorBufferTexture = SDL_CreateTexture(renderer, pixelFormat.format,
+		SDL_TEXTUREACCESS_STREAMING, SCREEN_WIDTH, SCREEN_HEIGHT);
+	if (!colorBufferTexture)
+	{
+		fprintf(stderr, "Error creating SDL texture.\n");
+		return (false);
+	}
+	return (true);
+}
+
+/**
+ * createFrameSurface - set up the window surface present backends
+ *
+ * Our own scaling only handles whole factors of the frame size and window
+ * surfaces in the frame's own format; anything else goes through
+ * SDL_BlitScaled.
+ * Return: true in case of success, false if it fails
+*/
+
+static bool createFrameSurface(void)
+{
+	windowSurface = SDL_GetWindowSurface(window);
+	if (windowSurface)
+	{
+		usePixelFormat(windowSurface->format->format);
+		frameSurface = SDL_CreateRGBSurfaceWithFormatFrom(
+			config.columnMajor ? transposeBuffer : colorBuffers[0],
+			SCREEN_WIDTH, SCREEN_HEIGHT, 32,
+			(int)(SCREEN_WIDTH * sizeof(color_t)), pixelFormat.format);
+	}
+	if (!windowSurface || !frameSurface)
+	{
+		fprintf(stderr, "Error creating the window surface.\n");
+		return (false);
+	}
+
+	presentScale = SDL_min(windowSurface->w / SCREEN_WIDTH,
+		windowSurface->h / SCREEN_HEIGHT);
+	if (presentMode == PRESENT_SCALED && (presentScale < 1
+		|| windowSurface->format->BytesPerPixel != sizeof(color_t)
+		|| windowSurface->format->Gmask != frameSurface->format->Gmask
+		|| windowSurface->format->Rmask != frameSurface->format->Rmask))
+	{
+		fprintf(stderr, "Window surface cannot be scaled, using SDL_BlitScaled.\n");
+		presentMode = PRESENT_SURFACE;
+	}
+	if (presentMode == PRESENT_SURFACE)
+	{
+		snprintf(presentName, sizeof(presentName), "surface blit");
+		return (true);
+	}
+
+	presentLeft = (windowSurface->w - SCREEN_WIDTH * presentScale) / 2;
+	presentTop = (windowSurface->h - SCREEN_HEIGHT * presentScale) / 2;
+	/* the borders around the centred frame are never drawn again */
+	SDL_FillRect(windowSurface, NULL, SDL_MapRGB(windowSurface->format, 0, 0, 0));
+	snprintf(presentName, sizeof(presentName), "surface scaled x%d",
+		presentScale);
+	return (true);
+}
 
 /**
  * initializeWindow - Initialize window to display the maze
@@ -12,7 +158,7 @@ static SDL_Window *window;
 bool initializeWindow(void)
 {
 	SDL_DisplayMode display_mode;
-	int fullScreenWidth, fullScreenHeight;
+	int fullScreenWidth, fullScreenHeight, i;
 
 	if (SDL_Init(SDL_INIT_EVERYTHING) != 0)
 	{
@@ -35,22 +181,30 @@ bool initializeWindow(void)
 		fprintf(stderr, "Error creating SDL window.\n");
 		return (false);
 	}
-	renderer = SDL_CreateRenderer(window, -1, 1);
-	if (!renderer)
+	/* allocate one colorbuffer for each frame that can be in flight */
+	for (i = 0; i < config.pipelineDepth; i++)
 	{
-		fprintf(stderr, "Error creating SDL renderer.\n");
+		colorBuffers[i] = malloc(sizeof(color_t) * SCREEN_WIDTH * SCREEN_HEIGHT);
+		if (!colorBuffers[i])
+		{
+			fprintf(stderr, "Error allocating the color buffer.\n");
+			return (false);
+		}
+	}
+	/* the column-major colorbuffer is rebuilt into rows before upload */
+	if (config.columnMajor)
+		transposeBuffer = malloc(sizeof(color_t) * SCREEN_WIDTH * SCREEN_HEIGHT);
+	useColorBuffer(0);
+	if (config.columnMajor && !transposeBuffer)
+	{
+		fprintf(stderr, "Error allocating the color buffer.\n");
 		return (false);
 	}
-	SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
-
-	/* allocate the total amount of bytes in memory to hold our colorbuffer */
-	colorBuffer = malloc(sizeof(color_t) * SCREEN_WIDTH * SCREEN_HEIGHT);
-
-	/* create an SDL_Texture to display the colorbuffer */
-	colorBufferTexture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA32,
-		SDL_TEXTUREACCESS_STREAMING, SCREEN_WIDTH, SCREEN_HEIGHT);
 
-	return (true);
+	presentMode = config.presentMode;
+	if (presentMode == PRESENT_RENDERER)
+		return (createRenderer());
+	return (createFrameSurface());
 }
 
 /**
@@ -60,42 +214,354 @@ bool initializeWindow(void)
 
 void destroyWindow(void)
 {
-	free(colorBuffer);
-	SDL_DestroyTexture(colorBufferTexture);
-	SDL_DestroyRenderer(renderer);
+	int i;
+
+	for (i = 0; i < MAX_PIPELINE_DEPTH; i++)
+		free(colorBuffers[i]);
+	free(transposeBuffer);
+	if (frameSurface)
+		SDL_FreeSurface(frameSurface);
+	if (colorBufferTexture)
+		SDL_DestroyTexture(colorBufferTexture);
+	if (renderer)
+		SDL_DestroyRenderer(renderer);
 	SDL_DestroyWindow(window);
 	SDL_Quit();
 }
 
 
 /**
- * clearColorBuffer - clear buffer for every frame
- * @color: color buffer
+ * lockColorBuffer - point the framebuffer at the pixels of a new frame
+ * @slot: pipeline slot the frame is rendered into
+ *
+ * The streaming texture is locked and drawn into directly, which saves
+ * the full-frame copy of SDL_UpdateTexture. The slot's colorbuffer is
+ * used instead when MAZE_BUFFERED or the column-major layout ask for it,
+ * when the texture cannot be locked (headless renderers), with the window
+ * surface backends, and when frames are rendered on the render thread,
+ * which must not call into SDL's renderer.
+*/
+
+void lockColorBuffer(int slot)
+{
+	void *pixels;
+	int pitch;
+
+	if (config.pipelineDepth > 1)
+	{
+		useColorBuffer(slot);
+		return;
+	}
+	textureLocked = presentMode == PRESENT_RENDERER
+		&& !config.bufferedPresent && !config.columnMajor
+		&& SDL_LockTexture(colorBufferTexture, NULL, &pixels, &pitch) == 0;
+	if (!textureLocked)
+	{
+		useColorBuffer(slot);
+		return;
+	}
+	framebuffer.pixels = pixels;
+	framebuffer.xStride = 1;
+	framebuffer.yStride = pitch / (int)sizeof(color_t);
+}
+
+/**
+ * fillSpan - fill a run of framebuffer pixels with one color
+ * @pixels: first pixel
+ * @count: number of pixels
+ * @stride: pixels between consecutive pixels of the run
+ * @color: fill color
 */
 
-void clearColorBuffer(color_t color)
+void fillSpan(color_t *pixels, int count, int stride, color_t color)
 {
 	int i;
 
-	for (i = 0; i < SCREEN_WIDTH * SCREEN_HEIGHT; i++)
-		colorBuffer[i] = color;
+	countWrites(pixels, count, stride);
+	if (stride == 1)
+	{
+		SDL_memset4(pixels, color, count);
+		return;
+	}
+	for (i = 0; i < count; i++)
+		pixels[i * stride] = color;
+}
+
+#ifdef DEBUG_OVERDRAW
+static Uint8 *writeCounts;
+static size_t writeCountsSize;
+static long overdrawTotals[3];
+static int overdrawFrames;
+
+/**
+ * countWrites - record framebuffer writes of the 3D view pass
+ * @pixels: first pixel written
+ * @count: number of pixels
+ * @stride: pixels between consecutive pixels of the run
+ *
+ * Counts are kept per framebuffer offset, which is unique in every
+ * layout. Bands write disjoint columns, so workers never share a count.
+*/
+
+void countWrites(const color_t *pixels, int count, int stride)
+{
+	size_t offset = (size_t)(pixels - framebuffer.pixels);
+	int i;
+
+	if (writeCounts == NULL)
+		return;
+	for (i = 0; i < count; i++)
+		if (writeCounts[offset + (size_t)i * stride] < 255)
+			writeCounts[offset + (size_t)i * stride]++;
+}
+
+/**
+ * checkOverdraw - tally and reset the write counts of this frame
+ *
+ * Fog and see-through walls rewrite pixels on purpose; fog works in place
+ * and is not counted, see-through walls count as overdraw. Any pixel left
+ * unwritten would show the previous frame, so it is reported at once.
+*/
+
+void checkOverdraw(void)
+{
+	size_t size = (size_t)(framebufferAt(SCREEN_WIDTH - 1, SCREEN_HEIGHT - 1)
+						   - framebuffer.pixels) + 1;
+	int x, y, writes;
+
+	if (writeCounts != NULL)
+	{
+		for (y = 0; y < SCREEN_HEIGHT; y++)
+			for (x = 0; x < SCREEN_WIDTH; x++)
+			{
+				writes = writeCounts[framebufferAt(x, y) - framebuffer.pixels];
+				overdrawTotals[writes < 2 ? writes : 2]++;
+				if (writes == 0 && overdrawTotals[0] == 1)
+					fprintf(stderr, "Pixel %d,%d was never written.\n", x, y);
+			}
+		overdrawFrames++;
+	}
+	if (size > writeCountsSize)
+	{
+		free(writeCounts);
+		writeCounts = malloc(size);
+		writeCountsSize = writeCounts != NULL ? size : 0;
+	}
+	if (writeCounts != NULL)
+		memset(writeCounts, 0, writeCountsSize);
+}
+
+/**
+ * overdrawReport - print the coverage totals of the checked frames
+ *
+*/
+
+void overdrawReport(void)
+{
+	if (overdrawFrames == 0)
+		return;
+	printf("overdraw over %d frames, per frame:\n", overdrawFrames);
+	printf("  %-12s %9.1f\n", "unwritten", (double)overdrawTotals[0] / overdrawFrames);
+	printf("  %-12s %9.1f\n", "written once", (double)overdrawTotals[1] / overdrawFrames);
+	printf("  %-12s %9.1f\n", "overdrawn", (double)overdrawTotals[2] / overdrawFrames);
+	free(writeCounts);
+}
+#endif
+
+/**
+ * transposeTile - copy a tile of the column-major colorbuffer into rows
+ * @source: column-major colorbuffer
+ * @x0: first column of the tile
+ * @y0: first row of the tile
+ * @x1: one past the last column of the tile
+ * @y1: one past the last row of the tile
+*/
+
+static void transposeTile(const color_t *source, int x0, int y0, int x1, int y1)
+{
+	int x, y;
+
+#ifdef __SSE2__
+	if ((x1 - x0) % 4 == 0 && (y1 - y0) % 4 == 0)
+	{
+		for (x = x0; x < x1; x += 4)
+			for (y = y0; y < y1; y += 4)
+			{
+				const color_t *src = &source[x * SCREEN_HEIGHT + y];
+				color_t *dst = &transposeBuffer[y * SCREEN_WIDTH + x];
+				__m128i c0 = _mm_loadu_si128((const __m128i *)src);
+				__m128i c1 = _mm_loadu_si128((const __m128i *)(src + SCREEN_HEIGHT));
+				__m128i c2 = _mm_loadu_si128((const __m128i *)(src + 2 * SCREEN_HEIGHT));
+				__m128i c3 = _mm_loadu_si128((const __m128i *)(src + 3 * SCREEN_HEIGHT));
+				__m128i t0 = _mm_unpacklo_epi32(c0, c1);
+				__m128i t1 = _mm_unpacklo_epi32(c2, c3);
+				__m128i t2 = _mm_unpackhi_epi32(c0, c1);
+				__m128i t3 = _mm_unpackhi_epi32(c2, c3);
+
+				_mm_storeu_si128((__m128i *)dst, _mm_unpacklo_epi64(t0, t1));
+				_mm_storeu_si128((__m128i *)(dst + SCREEN_WIDTH),
+					_mm_unpackhi_epi64(t0, t1));
+				_mm_storeu_si128((__m128i *)(dst + 2 * SCREEN_WIDTH),
+					_mm_unpacklo_epi64(t2, t3));
+				_mm_storeu_si128((__m128i *)(dst + 3 * SCREEN_WIDTH),
+					_mm_unpackhi_epi64(t2, t3));
+			}
+		return;
+	}
+#endif
+	for (x = x0; x < x1; x++)
+		for (y = y0; y < y1; y++)
+			transposeBuffer[y * SCREEN_WIDTH + x] = source[x * SCREEN_HEIGHT + y];
+}
+
+/**
+ * transposeColorBuffer - turn the column-major colorbuffer into rows
+ * @source: column-major colorbuffer
+ *
+ * Working in small tiles keeps both the columns read and the rows written
+ * in cache.
+ * Return: the row-major copy
+*/
+
+static color_t *transposeColorBuffer(const color_t *source)
+{
+	int x, y;
+
+	for (y = 0; y < SCREEN_HEIGHT; y += TRANSPOSE_BLOCK)
+		for (x = 0; x < SCREEN_WIDTH; x += TRANSPOSE_BLOCK)
+			transposeTile(source, x, y,
+				x + TRANSPOSE_BLOCK < SCREEN_WIDTH ? x + TRANSPOSE_BLOCK : SCREEN_WIDTH,
+				y + TRANSPOSE_BLOCK < SCREEN_HEIGHT ? y + TRANSPOSE_BLOCK : SCREEN_HEIGHT);
+	return (transposeBuffer);
+}
+
+/**
+ * scaleRow - widen a framebuffer row by the present scale
+ * @dst: first window surface pixel of the row
+ * @src: framebuffer row
+*/
+
+static void scaleRow(color_t *dst, const color_t *src)
+{
+	int x = 0, i;
+
+#ifdef __SSE2__
+	for (; presentScale <= 4 && x + 4 <= SCREEN_WIDTH; x += 4)
+	{
+		__m128i c = _mm_loadu_si128((const __m128i *)(src + x));
+		__m128i *out = (__m128i *)(dst + x * presentScale);
+
+		switch (presentScale)
+		{
+		case 1:
+			_mm_storeu_si128(out, c);
+			break;
+		case 2:
+			_mm_storeu_si128(out, _mm_unpacklo_epi32(c, c));
+			_mm_storeu_si128(out + 1, _mm_unpackhi_epi32(c, c));
+			break;
+		case 3:
+			_mm_storeu_si128(out, _mm_shuffle_epi32(c, 0x40));
+			_mm_storeu_si128(out + 1, _mm_shuffle_epi32(c, 0xA5));
+			_mm_storeu_si128(out + 2, _mm_shuffle_epi32(c, 0xFE));
+			break;
+		default:
+			_mm_storeu_si128(out, _mm_shuffle_epi32(c, 0x00));
+			_mm_storeu_si128(out + 1, _mm_shuffle_epi32(c, 0x55));
+			_mm_storeu_si128(out + 2, _mm_shuffle_epi32(c, 0xAA));
+			_mm_storeu_si128(out + 3, _mm_shuffle_epi32(c, 0xFF));
+		}
+	}
+#endif
+	for (; x < SCREEN_WIDTH; x++)
+		for (i = 0; i < presentScale; i++)
+			dst[x * presentScale + i] = src[x];
+}
+
+/**
+ * scaleRows - worker job scaling framebuffer rows onto the window surface
+ * @start: first framebuffer row
+ * @end: one past the last framebuffer row
+ * @data: row-major frame
+ *
+ * Each row is widened once and then copied down for the remaining lines.
+*/
+
+static void scaleRows(int start, int end, void *data)
+{
+	const color_t *frame = data;
+	size_t rowBytes = (size_t)SCREEN_WIDTH * presentScale * sizeof(color_t);
+	Uint8 *dst;
+	int y, i;
+
+	for (y = start; y < end; y++)
+	{
+		dst = (Uint8 *)windowSurface->pixels
+			+ (size_t)(presentTop + y * presentScale) * windowSurface->pitch
+			+ (size_t)presentLeft * sizeof(color_t);
+		scaleRow((color_t *)dst, frame + (size_t)y * SCREEN_WIDTH);
+		for (i = 1; i < presentScale; i++)
+			memcpy(dst + (size_t)i * windowSurface->pitch, dst, rowBytes);
+	}
 }
 
 /**
  * renderColorBuffer - render buffer for every frame
+ * @slot: pipeline slot of the finished frame
  *
+ * Only the thread that created the window calls this.
 */
 
-void renderColorBuffer(void)
+void renderColorBuffer(int slot)
 {
-	SDL_UpdateTexture(
-		colorBufferTexture,
-		NULL,
-		colorBuffer,
-		(int)(SCREEN_WIDTH * sizeof(color_t))
-	);
-	SDL_RenderCopy(renderer, colorBufferTexture, NULL, NULL);
-	SDL_RenderPresent(renderer);
+	color_t *frame;
+
+	if (textureLocked)
+	{
+		SDL_UnlockTexture(colorBufferTexture);
+		textureLocked = false;
+		SDL_RenderCopy(renderer, colorBufferTexture, NULL, NULL);
+		SDL_RenderPresent(renderer);
+		return;
+	}
+	frame = config.columnMajor ? transposeColorBuffer(colorBuffers[slot])
+		: colorBuffers[slot];
+	switch (presentMode)
+	{
+	case PRESENT_SURFACE:
+		/* the surface only borrows its pixels, so it can follow the slot */
+		frameSurface->pixels = frame;
+		SDL_BlitScaled(frameSurface, NULL, windowSurface, NULL);
+		SDL_UpdateWindowSurface(window);
+		break;
+	case PRESENT_SCALED:
+		if (SDL_MUSTLOCK(windowSurface) && SDL_LockSurface(windowSurface) != 0)
+			break;
+		/* the worker pool belongs to the render thread when there is one */
+		if (config.pipelineDepth > 1)
+			scaleRows(0, SCREEN_HEIGHT, frame);
+		else
+			runWorkers(scaleRows, SCREEN_HEIGHT, PRESENT_ROW_CHUNK, frame);
+		if (SDL_MUSTLOCK(windowSurface))
+			SDL_UnlockSurface(windowSurface);
+		SDL_UpdateWindowSurface(window);
+		break;
+	default:
+		SDL_UpdateTexture(colorBufferTexture, NULL, frame,
+			(int)(SCREEN_WIDTH * sizeof(color_t)));
+		SDL_RenderCopy(renderer, colorBufferTexture, NULL, NULL);
+		SDL_RenderPresent(renderer);
+	}
+}
+
+/**
+ * getPresentName - describe the present backend in use
+ * Return: a short human-readable name
+*/
+
+const char *getPresentName(void)
+{
+	return (presentName);
 }
 
 /**
@@ -107,5 +573,5 @@ void renderColorBuffer(void)
 
 void drawPixel(int x, int y, color_t color)
 {
-	colorBuffer[(SCREEN_WIDTH * y) + x] = color;
+	*framebufferAt(x, y) = color;
 }
@@ -0,0 +1,162 @@
+#include "../headers/header.h"
+
+static SDL_Thread *threads[MAX_WORKERS];
+static int numWorkers;
+static SDL_mutex *poolLock;
+static SDL_cond *jobReady, *jobDone;
+static unsigned int jobGeneration;
+static int busyWorkers;
+static bool stopping;
+
+static worker_job_t currentJob;
+static void *currentData;
+static int jobTotal, jobChunk;
+static SDL_atomic_t nextIndex;
+
+/**
+ * runChunks - claim chunks of the current job until none are left
+ *
+*/
+
+static void runChunks(void)
+{
+	int start;
+
+	while ((start = SDL_AtomicAdd(&nextIndex, jobChunk)) < jobTotal)
+	{
+		int end = start + jobChunk;
+
+		currentJob(start, end < jobTotal ? end : jobTotal, currentData);
+	}
+}
+
+/**
+ * workerMain - body of each pool thread
+ * @data: unused
+ * Return: 0 when the pool is shut down
+*/
+
+static int workerMain(void *data)
+{
+	unsigned int seenGeneration = 0;
+
+	(void)data;
+	for (;;)
+	{
+		SDL_LockMutex(poolLock);
+		while (!stopping && jobGeneration == seenGeneration)
+			SDL_CondWait(jobReady, poolLock);
+		if (stopping)
+		{
+			SDL_UnlockMutex(poolLock);
+			return (0);
+		}
+		seenGeneration = jobGeneration;
+		SDL_UnlockMutex(poolLock);
+
+		runChunks();
+
+		SDL_LockMutex(poolLock);
+		if (--busyWorkers == 0)
+			SDL_CondSignal(jobDone);
+		SDL_UnlockMutex(poolLock);
+	}
+}
+
+/**
+ * initWorkers - start the persistent worker threads
+ * @numThreads: total threads working on a job, the caller included
+ * Return: true in case of success, false if it fails
+*/
+
+bool initWorkers(int numThreads)
+{
+	int i;
+
+	poolLock = SDL_CreateMutex();
+	jobReady = SDL_CreateCond();
+	jobDone = SDL_CreateCond();
+	if (!poolLock || !jobReady || !jobDone)
+	{
+		fprintf(stderr, "Error creating worker pool: %s\n", SDL_GetError());
+		return (false);
+	}
+
+	stopping = false;
+	numWorkers = 0;
+	for (i = 0; i < numThreads - 1 && i < MAX_WORKERS; i++)
+	{
+		threads[i] = SDL_CreateThread(workerMain, "worker", NULL);
+		if (!threads[i])
+		{
+			fprintf(stderr, "Error creating worker thread: %s\n", SDL_GetError());
+			break;
+		}
+		numWorkers++;
+	}
+	return (true);
+}
+
+/**
+ * runWorkers - run a job over [0, total) on the pool and wait for it
+ * @job: function called for each chunk
+ * @total: size of the index range
+ * @chunkSize: number of indices claimed at a time
+ * @data: passed through to job
+ *
+ * The calling thread works on the job too, so with no workers the job
+ * simply runs inline.
+*/
+
+void runWorkers(worker_job_t job, int total, int chunkSize, void *data)
+{
+	if (numWorkers == 0)
+	{
+		job(0, total, data);
+		return;
+	}
+
+	SDL_LockMutex(poolLock);
+	currentJob = job;
+	currentData = data;
+	jobTotal = total;
+	jobChunk = chunkSize;
+	SDL_AtomicSet(&nextIndex, 0);
+	busyWorkers = numWorkers;
+	jobGeneration++;
+	SDL_CondBroadcast(jobReady);
+	SDL_UnlockMutex(poolLock);
+
+	runChunks();
+
+	SDL_LockMutex(poolLock);
+	while (busyWorkers > 0)
+		SDL_CondWait(jobDone, poolLock);
+	SDL_UnlockMutex(poolLock);
+}
+
+/**
+ * destroyWorkers - stop and join the worker threads
+ *
+*/
+
+void destroyWorkers(void)
+{
+	int i;
+
+	if (!poolLock)
+		return;
+	SDL_LockMutex(poolLock);
+	stopping = true;
+	SDL_CondBroadcast(jobReady);
+	SDL_UnlockMutex(poolLock);
+
+	for (i = 0; i < numWorkers; i++)
+		SDL_WaitThread(threads[i], NULL);
+	numWorkers = 0;
+
+	SDL_DestroyCond(jobDone);
+	SDL_DestroyCond(jobReady);
+	SDL_DestroyMutex(poolLock);
+	poolLock = NULL;
+}